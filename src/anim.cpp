@@ -0,0 +1,104 @@
+//-----------------------------------------------------------------------------
+/*
+
+Compressed Animation Playback
+
+Animations are encoded offline (tools/animenc.py) into a program memory
+stream: a header, a palette of up to 256 colours, then the frames.
+
+Each frame is a list of operations that together cover every led once:
+skip n leds (unchanged from the last frame), a run of n leds of one
+palette colour, or n literal palette indices. Frame 0 is encoded against
+an all black frame and the frame is cleared when the animation loops.
+
+The decoder writes straight into the frame buffer, which must hold the
+last decoded frame, so there is no scratch frame. It reads the stream one
+byte at a time and keeps only a pointer between frames.
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+
+#include "hal.h"
+#include "color.h"
+#include "anim.h"
+
+//-----------------------------------------------------------------------------
+
+// open an animation, return 0 on success
+int anim_open(ANIM_PLAYER *a, const uint8_t *data) {
+    memset(a, 0, sizeof(ANIM_PLAYER));
+    if (pgm_read_byte(&data[ANIM_HDR_VERSION]) != ANIM_VERSION) {
+        return -1;
+    }
+    uint16_t ncolors = pgm_read_byte(&data[ANIM_HDR_COLORS]);
+    if (ncolors == 0) {
+        ncolors = 256;
+    }
+    a->nleds = pgm_read_byte(&data[ANIM_HDR_LEDS]);
+    a->nframes = pgm_read_word(&data[ANIM_HDR_FRAMES]);
+    a->period = pgm_read_byte(&data[ANIM_HDR_PERIOD]);
+    a->palette = &data[ANIM_HDR_SIZE];
+    a->frames = a->palette + (ncolors * 3);
+    a->pos = a->frames;
+    return 0;
+}
+
+static void anim_color(const ANIM_PLAYER *a, RGB *rgb, uint8_t idx) {
+    const uint8_t *p = &a->palette[idx * 3];
+    rgb->r = pgm_read_byte(p);
+    rgb->g = pgm_read_byte(p + 1);
+    rgb->b = pgm_read_byte(p + 2);
+}
+
+// decode the next frame into a frame of n leds, return the frame number
+int anim_frame(ANIM_PLAYER *a, RGB *frame, uint8_t n) {
+    if (a->nframes == 0) {
+        return -1;
+    }
+    if (a->frame == a->nframes) {
+        // loop: frame 0 is encoded against black
+        a->frame = 0;
+        a->pos = a->frames;
+        memset(frame, 0, n * sizeof(RGB));
+    }
+
+    const uint8_t *p = a->pos;
+    uint8_t i = 0;
+    while (i < a->nleds) {
+        uint8_t op = pgm_read_byte(p++);
+        uint8_t count = (op & ~ANIM_OP_MASK) + 1;
+        switch (op & ANIM_OP_MASK) {
+            case ANIM_OP_RUN: {
+                RGB rgb;
+                anim_color(a, &rgb, pgm_read_byte(p++));
+                for (uint8_t j = 0; j < count; j ++, i ++) {
+                    if (i < n) {
+                        frame[i] = rgb;
+                    }
+                }
+                break;
+            }
+            case ANIM_OP_LIT: {
+                for (uint8_t j = 0; j < count; j ++, i ++) {
+                    uint8_t idx = pgm_read_byte(p++);
+                    if (i < n) {
+                        anim_color(a, &frame[i], idx);
+                    }
+                }
+                break;
+            }
+            default: {
+                // skip
+                i += count;
+                break;
+            }
+        }
+    }
+    a->pos = p;
+    return a->frame ++;
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,60 @@
+//-----------------------------------------------------------------------------
+/*
+
+Compressed Animation Playback
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef ANIM_H
+#define ANIM_H
+
+//-----------------------------------------------------------------------------
+// stream format (see tools/animenc.py)
+
+#define ANIM_VERSION 1
+
+// header
+#define ANIM_HDR_VERSION    0
+#define ANIM_HDR_LEDS       1
+#define ANIM_HDR_FRAMES     2   // 16 bits, little endian
+#define ANIM_HDR_PERIOD     4   // msec per frame
+#define ANIM_HDR_COLORS     5   // palette size, 0 = 256
+#define ANIM_HDR_SIZE       6
+
+// frame operations: op (bits 7..6), count - 1 (bits 5..0)
+#define ANIM_OP_SKIP    (0 << 6)    // leave count leds unchanged
+#define ANIM_OP_RUN     (1 << 6)    // set count leds to the next palette index
+#define ANIM_OP_LIT     (2 << 6)    // set count leds to the next count indices
+#define ANIM_OP_MASK    (3 << 6)
+#define ANIM_COUNT_MAX  64
+
+//-----------------------------------------------------------------------------
+
+typedef struct anim_player {
+
+    const uint8_t *palette; // in program memory
+    const uint8_t *frames;  // first frame
+    const uint8_t *pos;     // next frame
+    uint16_t nframes;
+    uint16_t frame;         // next frame number
+    uint8_t nleds;
+    uint8_t period;
+
+} ANIM_PLAYER;
+
+// animations (in program memory, generated by tools/animenc.py)
+extern const uint8_t * const anim_table[] PROGMEM;
+extern const uint8_t anim_count;
+
+//-----------------------------------------------------------------------------
+// API functions
+
+int anim_open(ANIM_PLAYER *a, const uint8_t *data);
+int anim_frame(ANIM_PLAYER *a, RGB *frame, uint8_t n);
+
+//-----------------------------------------------------------------------------
+
+#endif // ANIM_H
+
+//-----------------------------------------------------------------------------
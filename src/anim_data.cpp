@@ -0,0 +1,184 @@
+//-----------------------------------------------------------------------------
+/*
+
+Animation Data
+
+Generated by: animenc.py --demo comet --demo bars -o src/anim_data.cpp
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+
+#include "hal.h"
+#include "color.h"
+#include "anim.h"
+
+//-----------------------------------------------------------------------------
+
+// comet, 110 frames, 56 leds, 7% of raw: 1333 bytes
+static const uint8_t anim_comet[] PROGMEM = {
+    0x01, 0x38, 0x6e, 0x00, 0x21, 0x9d, 0x00, 0x00, 0x00, 0x00, 0x00, 0x11, 0x00, 0x00, 0x33, 0x00,
+    0x00, 0x77, 0x00, 0x00, 0xff, 0x00, 0x11, 0x00, 0x00, 0x11, 0x11, 0x00, 0x11, 0x33, 0x00, 0x11,
+    0x77, 0x00, 0x11, 0xff, 0x00, 0x22, 0x33, 0x00, 0x22, 0x77, 0x00, 0x22, 0xff, 0x00, 0x33, 0x00,
+    0x00, 0x33, 0x11, 0x00, 0x33, 0x22, 0x00, 0x33, 0x33, 0x00, 0x33, 0x77, 0x00, 0x33, 0xff, 0x00,
+    0x44, 0x77, 0x00, 0x44, 0xff, 0x00, 0x55, 0x77, 0x00, 0x55, 0xff, 0x00, 0x66, 0x77, 0x00, 0x66,
+    0xff, 0x00, 0x77, 0x00, 0x00, 0x77, 0x11, 0x00, 0x77, 0x22, 0x00, 0x77, 0x33, 0x00, 0x77, 0x44,
+    0x00, 0x77, 0x55, 0x00, 0x77, 0x66, 0x00, 0x77, 0x77, 0x00, 0x77, 0xff, 0x00, 0x88, 0xff, 0x00,
+    0x99, 0xff, 0x00, 0xaa, 0xff, 0x00, 0xbb, 0xff, 0x00, 0xcc, 0xff, 0x00, 0xdd, 0xff, 0x00, 0xee,
+    0xff, 0x00, 0xff, 0x00, 0x00, 0xff, 0x11, 0x00, 0xff, 0x22, 0x00, 0xff, 0x33, 0x00, 0xff, 0x44,
+    0x00, 0xff, 0x55, 0x00, 0xff, 0x66, 0x00, 0xff, 0x77, 0x00, 0xff, 0x88, 0x00, 0xff, 0x99, 0x00,
+    0xff, 0xaa, 0x00, 0xff, 0xbb, 0x00, 0xff, 0xcc, 0x00, 0xff, 0xdd, 0x00, 0xff, 0xee, 0x00, 0xff,
+    0xff, 0x11, 0x00, 0x00, 0x11, 0x00, 0x11, 0x11, 0x00, 0x33, 0x11, 0x00, 0x77, 0x11, 0x00, 0xff,
+    0x11, 0x11, 0x00, 0x11, 0x33, 0x00, 0x11, 0x77, 0x00, 0x11, 0xff, 0x00, 0x22, 0x00, 0x33, 0x22,
+    0x00, 0x77, 0x22, 0x00, 0xff, 0x22, 0x33, 0x00, 0x22, 0x77, 0x00, 0x22, 0xff, 0x00, 0x33, 0x00,
+    0x00, 0x33, 0x00, 0x11, 0x33, 0x00, 0x22, 0x33, 0x00, 0x33, 0x33, 0x00, 0x77, 0x33, 0x00, 0xff,
+    0x33, 0x11, 0x00, 0x33, 0x22, 0x00, 0x33, 0x33, 0x00, 0x33, 0x77, 0x00, 0x33, 0xff, 0x00, 0x44,
+    0x00, 0x77, 0x44, 0x00, 0xff, 0x44, 0x77, 0x00, 0x44, 0xff, 0x00, 0x55, 0x00, 0x77, 0x55, 0x00,
+    0xff, 0x55, 0x77, 0x00, 0x55, 0xff, 0x00, 0x66, 0x00, 0x77, 0x66, 0x00, 0xff, 0x66, 0x77, 0x00,
+    0x66, 0xff, 0x00, 0x77, 0x00, 0x00, 0x77, 0x00, 0x11, 0x77, 0x00, 0x22, 0x77, 0x00, 0x33, 0x77,
+    0x00, 0x44, 0x77, 0x00, 0x55, 0x77, 0x00, 0x66, 0x77, 0x00, 0x77, 0x77, 0x00, 0xff, 0x77, 0x11,
+    0x00, 0x77, 0x22, 0x00, 0x77, 0x33, 0x00, 0x77, 0x44, 0x00, 0x77, 0x55, 0x00, 0x77, 0x66, 0x00,
+    0x77, 0x77, 0x00, 0x77, 0xff, 0x00, 0x88, 0x00, 0xff, 0x88, 0xff, 0x00, 0x99, 0x00, 0xff, 0x99,
+    0xff, 0x00, 0xaa, 0x00, 0xff, 0xaa, 0xff, 0x00, 0xbb, 0x00, 0xff, 0xbb, 0xff, 0x00, 0xcc, 0x00,
+    0xff, 0xcc, 0xff, 0x00, 0xdd, 0x00, 0xff, 0xdd, 0xff, 0x00, 0xee, 0x00, 0xff, 0xee, 0xff, 0x00,
+    0xff, 0x00, 0x00, 0xff, 0x00, 0x11, 0xff, 0x00, 0x22, 0xff, 0x00, 0x33, 0xff, 0x00, 0x44, 0xff,
+    0x00, 0x55, 0xff, 0x00, 0x66, 0xff, 0x00, 0x77, 0xff, 0x00, 0x88, 0xff, 0x00, 0x99, 0xff, 0x00,
+    0xaa, 0xff, 0x00, 0xbb, 0xff, 0x00, 0xcc, 0xff, 0x00, 0xdd, 0xff, 0x00, 0xee, 0xff, 0x00, 0xff,
+    0xff, 0x11, 0x00, 0xff, 0x22, 0x00, 0xff, 0x33, 0x00, 0xff, 0x44, 0x00, 0xff, 0x55, 0x00, 0xff,
+    0x66, 0x00, 0xff, 0x77, 0x00, 0xff, 0x88, 0x00, 0xff, 0x99, 0x00, 0xff, 0xaa, 0x00, 0xff, 0xbb,
+    0x00, 0xff, 0xcc, 0x00, 0xff, 0xdd, 0x00, 0xff, 0xee, 0x00, 0xff, 0xff, 0x00, 0x80, 0x7e, 0x36,
+    0x81, 0x5f, 0x7e, 0x35, 0x82, 0x48, 0x5f, 0x8e, 0x34, 0x83, 0x39, 0x48, 0x68, 0x8f, 0x33, 0x84,
+    0x00, 0x39, 0x48, 0x68, 0x90, 0x32, 0x00, 0x84, 0x00, 0x39, 0x4e, 0x69, 0x91, 0x31, 0x01, 0x84,
+    0x00, 0x39, 0x4e, 0x69, 0x92, 0x30, 0x02, 0x84, 0x00, 0x39, 0x4e, 0x6a, 0x93, 0x2f, 0x03, 0x84,
+    0x00, 0x39, 0x4e, 0x6a, 0x93, 0x2e, 0x04, 0x84, 0x00, 0x39, 0x4e, 0x6a, 0x94, 0x2d, 0x05, 0x84,
+    0x00, 0x3e, 0x4f, 0x6b, 0x95, 0x2c, 0x06, 0x84, 0x00, 0x3e, 0x4f, 0x6b, 0x96, 0x2b, 0x07, 0x84,
+    0x00, 0x3e, 0x4f, 0x6c, 0x97, 0x2a, 0x08, 0x84, 0x00, 0x3e, 0x4f, 0x6c, 0x98, 0x29, 0x09, 0x84,
+    0x00, 0x3e, 0x50, 0x6d, 0x99, 0x28, 0x0a, 0x84, 0x00, 0x3e, 0x50, 0x6d, 0x9a, 0x27, 0x0b, 0x84,
+    0x00, 0x3e, 0x50, 0x6d, 0x9a, 0x26, 0x0c, 0x84, 0x00, 0x3e, 0x50, 0x6e, 0x9b, 0x25, 0x0d, 0x84,
+    0x00, 0x3e, 0x50, 0x6e, 0x9c, 0x24, 0x0e, 0x84, 0x00, 0x3e, 0x50, 0x6e, 0x9c, 0x23, 0x0f, 0x84,
+    0x00, 0x3e, 0x50, 0x6e, 0x7d, 0x22, 0x10, 0x84, 0x00, 0x3e, 0x50, 0x5d, 0x7b, 0x21, 0x11, 0x84,
+    0x00, 0x3e, 0x50, 0x5d, 0x79, 0x20, 0x12, 0x84, 0x00, 0x3e, 0x45, 0x59, 0x77, 0x1f, 0x13, 0x84,
+    0x00, 0x3e, 0x45, 0x59, 0x77, 0x1e, 0x14, 0x84, 0x00, 0x3e, 0x45, 0x59, 0x75, 0x1d, 0x15, 0x84,
+    0x00, 0x3e, 0x45, 0x55, 0x73, 0x1c, 0x16, 0x84, 0x00, 0x3e, 0x45, 0x55, 0x71, 0x1b, 0x17, 0x84,
+    0x00, 0x05, 0x3f, 0x51, 0x6f, 0x1a, 0x18, 0x84, 0x00, 0x05, 0x3f, 0x51, 0x5e, 0x19, 0x19, 0x84,
+    0x00, 0x05, 0x3f, 0x46, 0x5a, 0x18, 0x1a, 0x84, 0x00, 0x05, 0x3f, 0x46, 0x56, 0x17, 0x1b, 0x84,
+    0x00, 0x05, 0x3f, 0x46, 0x56, 0x16, 0x1c, 0x84, 0x00, 0x05, 0x0d, 0x40, 0x52, 0x15, 0x1d, 0x84,
+    0x00, 0x05, 0x0d, 0x40, 0x47, 0x14, 0x1e, 0x84, 0x00, 0x05, 0x0d, 0x19, 0x41, 0x13, 0x1f, 0x84,
+    0x00, 0x05, 0x0d, 0x19, 0x29, 0x12, 0x20, 0x84, 0x00, 0x05, 0x0d, 0x19, 0x29, 0x11, 0x21, 0x84,
+    0x00, 0x05, 0x0d, 0x19, 0x2a, 0x10, 0x22, 0x84, 0x00, 0x05, 0x0d, 0x1a, 0x2b, 0x0f, 0x23, 0x84,
+    0x00, 0x05, 0x0d, 0x1a, 0x2b, 0x0e, 0x24, 0x84, 0x00, 0x05, 0x0d, 0x1a, 0x2c, 0x0d, 0x25, 0x84,
+    0x00, 0x05, 0x0e, 0x1b, 0x2d, 0x0c, 0x26, 0x84, 0x00, 0x05, 0x0e, 0x1b, 0x2e, 0x0b, 0x27, 0x84,
+    0x00, 0x05, 0x0e, 0x1c, 0x2f, 0x0a, 0x28, 0x84, 0x00, 0x05, 0x0e, 0x1c, 0x30, 0x09, 0x29, 0x84,
+    0x00, 0x06, 0x0f, 0x1d, 0x31, 0x08, 0x2a, 0x84, 0x00, 0x06, 0x0f, 0x1d, 0x31, 0x07, 0x2b, 0x84,
+    0x00, 0x06, 0x0f, 0x1d, 0x32, 0x06, 0x2c, 0x84, 0x00, 0x06, 0x0f, 0x1e, 0x33, 0x05, 0x2d, 0x84,
+    0x00, 0x06, 0x0f, 0x1e, 0x34, 0x04, 0x2e, 0x84, 0x00, 0x06, 0x10, 0x1f, 0x35, 0x03, 0x2f, 0x84,
+    0x00, 0x06, 0x10, 0x1f, 0x36, 0x02, 0x30, 0x84, 0x00, 0x06, 0x10, 0x20, 0x37, 0x01, 0x31, 0x85,
+    0x00, 0x06, 0x10, 0x20, 0x38, 0x00, 0x32, 0x84, 0x00, 0x06, 0x10, 0x20, 0x38, 0x33, 0x41, 0x00,
+    0x81, 0x38, 0x20, 0x34, 0x82, 0x28, 0x20, 0x10, 0x33, 0x83, 0x27, 0x17, 0x10, 0x06, 0x32, 0x84,
+    0x26, 0x17, 0x10, 0x06, 0x00, 0x31, 0x85, 0x25, 0x15, 0x0a, 0x06, 0x00, 0x00, 0x30, 0x83, 0x24,
+    0x15, 0x0a, 0x06, 0x42, 0x00, 0x2f, 0x83, 0x23, 0x13, 0x0a, 0x06, 0x43, 0x00, 0x2e, 0x83, 0x22,
+    0x13, 0x0a, 0x06, 0x44, 0x00, 0x2d, 0x83, 0x22, 0x13, 0x0a, 0x06, 0x45, 0x00, 0x2c, 0x83, 0x21,
+    0x11, 0x07, 0x01, 0x46, 0x00, 0x2b, 0x83, 0x18, 0x11, 0x07, 0x01, 0x47, 0x00, 0x2a, 0x83, 0x16,
+    0x0b, 0x07, 0x01, 0x48, 0x00, 0x29, 0x83, 0x14, 0x0b, 0x07, 0x01, 0x49, 0x00, 0x28, 0x83, 0x12,
+    0x08, 0x02, 0x01, 0x4a, 0x00, 0x27, 0x83, 0x0c, 0x08, 0x02, 0x01, 0x4b, 0x00, 0x26, 0x83, 0x0c,
+    0x08, 0x02, 0x01, 0x4c, 0x00, 0x25, 0x83, 0x09, 0x03, 0x02, 0x01, 0x4d, 0x00, 0x24, 0x83, 0x04,
+    0x03, 0x02, 0x01, 0x4e, 0x00, 0x23, 0x83, 0x04, 0x03, 0x02, 0x01, 0x4f, 0x00, 0x22, 0x83, 0x3d,
+    0x03, 0x02, 0x01, 0x50, 0x00, 0x21, 0x83, 0x44, 0x3c, 0x02, 0x01, 0x51, 0x00, 0x20, 0x83, 0x4d,
+    0x3c, 0x02, 0x01, 0x52, 0x00, 0x1f, 0x83, 0x54, 0x43, 0x3b, 0x01, 0x53, 0x00, 0x1e, 0x83, 0x54,
+    0x43, 0x3b, 0x01, 0x54, 0x00, 0x1d, 0x83, 0x58, 0x43, 0x3b, 0x01, 0x55, 0x00, 0x1c, 0x83, 0x5c,
+    0x4c, 0x3b, 0x01, 0x56, 0x00, 0x1b, 0x83, 0x67, 0x4c, 0x3b, 0x01, 0x57, 0x00, 0x1a, 0x83, 0x70,
+    0x53, 0x42, 0x3a, 0x58, 0x00, 0x19, 0x83, 0x72, 0x53, 0x42, 0x3a, 0x59, 0x00, 0x18, 0x83, 0x74,
+    0x57, 0x42, 0x3a, 0x5a, 0x00, 0x17, 0x83, 0x76, 0x57, 0x42, 0x3a, 0x5b, 0x00, 0x16, 0x83, 0x76,
+    0x57, 0x42, 0x3a, 0x5c, 0x00, 0x15, 0x83, 0x78, 0x5b, 0x4b, 0x3a, 0x5d, 0x00, 0x14, 0x83, 0x7a,
+    0x5b, 0x4b, 0x3a, 0x5e, 0x00, 0x13, 0x83, 0x7c, 0x66, 0x4b, 0x3a, 0x5f, 0x00, 0x12, 0x83, 0x8d,
+    0x66, 0x4b, 0x3a, 0x60, 0x00, 0x11, 0x83, 0x8d, 0x66, 0x4b, 0x3a, 0x61, 0x00, 0x10, 0x83, 0x8c,
+    0x66, 0x4b, 0x3a, 0x62, 0x00, 0x0f, 0x83, 0x8b, 0x65, 0x4b, 0x3a, 0x63, 0x00, 0x0e, 0x83, 0x8b,
+    0x65, 0x4b, 0x3a, 0x64, 0x00, 0x0d, 0x83, 0x8a, 0x65, 0x4b, 0x3a, 0x65, 0x00, 0x0c, 0x83, 0x89,
+    0x64, 0x4a, 0x3a, 0x66, 0x00, 0x0b, 0x83, 0x88, 0x64, 0x4a, 0x3a, 0x67, 0x00, 0x0a, 0x83, 0x87,
+    0x63, 0x4a, 0x3a, 0x68, 0x00, 0x09, 0x83, 0x86, 0x63, 0x4a, 0x3a, 0x69, 0x00, 0x08, 0x83, 0x85,
+    0x62, 0x49, 0x39, 0x6a, 0x00, 0x07, 0x83, 0x84, 0x62, 0x49, 0x39, 0x6b, 0x00, 0x06, 0x83, 0x84,
+    0x62, 0x49, 0x39, 0x6c, 0x00, 0x05, 0x83, 0x83, 0x61, 0x49, 0x39, 0x6d, 0x00, 0x04, 0x83, 0x82,
+    0x61, 0x49, 0x39, 0x6e, 0x00, 0x03, 0x83, 0x81, 0x60, 0x48, 0x39, 0x6f, 0x00, 0x02, 0x83, 0x80,
+    0x60, 0x48, 0x39, 0x70, 0x00, 0x01, 0x83, 0x7f, 0x5f, 0x48, 0x39, 0x71, 0x00, 0x00, 0x83, 0x7e,
+    0x5f, 0x48, 0x39, 0x72, 0x00,
+};
+
+// bars, 174 frames, 56 leds, 3% of raw: 1017 bytes
+static const uint8_t anim_bars[] PROGMEM = {
+    0x01, 0x38, 0xae, 0x00, 0x21, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0xff, 0x00, 0x00,
+    0xff, 0xff, 0xff, 0x00, 0x00, 0xff, 0x00, 0xff, 0xff, 0xff, 0x00, 0x37, 0x80, 0x04, 0x35, 0x80,
+    0x04, 0x00, 0x80, 0x04, 0x33, 0x41, 0x04, 0x01, 0x80, 0x04, 0x31, 0x42, 0x04, 0x02, 0x80, 0x04,
+    0x2f, 0x43, 0x04, 0x03, 0x80, 0x04, 0x2d, 0x44, 0x04, 0x04, 0x80, 0x04, 0x2b, 0x45, 0x04, 0x05,
+    0x80, 0x04, 0x29, 0x46, 0x04, 0x06, 0x80, 0x04, 0x27, 0x47, 0x04, 0x07, 0x80, 0x04, 0x25, 0x48,
+    0x04, 0x08, 0x80, 0x04, 0x23, 0x49, 0x04, 0x09, 0x80, 0x04, 0x21, 0x4a, 0x04, 0x0a, 0x80, 0x04,
+    0x1f, 0x4b, 0x04, 0x0b, 0x80, 0x04, 0x1d, 0x4c, 0x04, 0x0c, 0x80, 0x04, 0x1b, 0x4d, 0x04, 0x0d,
+    0x80, 0x04, 0x19, 0x4e, 0x04, 0x0e, 0x80, 0x04, 0x17, 0x4f, 0x04, 0x0f, 0x80, 0x04, 0x15, 0x50,
+    0x04, 0x10, 0x80, 0x04, 0x13, 0x51, 0x04, 0x11, 0x80, 0x04, 0x11, 0x52, 0x04, 0x12, 0x80, 0x04,
+    0x0f, 0x53, 0x04, 0x13, 0x80, 0x04, 0x0d, 0x54, 0x04, 0x14, 0x80, 0x04, 0x0b, 0x55, 0x04, 0x15,
+    0x80, 0x04, 0x09, 0x56, 0x04, 0x16, 0x80, 0x04, 0x07, 0x57, 0x04, 0x17, 0x80, 0x04, 0x05, 0x58,
+    0x04, 0x18, 0x80, 0x04, 0x03, 0x59, 0x04, 0x19, 0x80, 0x04, 0x01, 0x5a, 0x04, 0x1a, 0x5c, 0x04,
+    0x37, 0x80, 0x06, 0x35, 0x80, 0x06, 0x00, 0x80, 0x06, 0x33, 0x41, 0x06, 0x01, 0x80, 0x06, 0x31,
+    0x42, 0x06, 0x02, 0x80, 0x06, 0x2f, 0x43, 0x06, 0x03, 0x80, 0x06, 0x2d, 0x44, 0x06, 0x04, 0x80,
+    0x06, 0x2b, 0x45, 0x06, 0x05, 0x80, 0x06, 0x29, 0x46, 0x06, 0x06, 0x80, 0x06, 0x27, 0x47, 0x06,
+    0x07, 0x80, 0x06, 0x25, 0x48, 0x06, 0x08, 0x80, 0x06, 0x23, 0x49, 0x06, 0x09, 0x80, 0x06, 0x21,
+    0x4a, 0x06, 0x0a, 0x80, 0x06, 0x1f, 0x4b, 0x06, 0x0b, 0x80, 0x06, 0x1d, 0x4c, 0x06, 0x0c, 0x80,
+    0x06, 0x1b, 0x4d, 0x06, 0x0d, 0x80, 0x06, 0x19, 0x4e, 0x06, 0x0e, 0x80, 0x06, 0x17, 0x4f, 0x06,
+    0x0f, 0x80, 0x06, 0x15, 0x50, 0x06, 0x10, 0x80, 0x06, 0x13, 0x51, 0x06, 0x11, 0x80, 0x06, 0x11,
+    0x52, 0x06, 0x12, 0x80, 0x06, 0x0f, 0x53, 0x06, 0x13, 0x80, 0x06, 0x0d, 0x54, 0x06, 0x14, 0x80,
+    0x06, 0x0b, 0x55, 0x06, 0x15, 0x80, 0x06, 0x09, 0x56, 0x06, 0x16, 0x80, 0x06, 0x07, 0x57, 0x06,
+    0x17, 0x80, 0x06, 0x05, 0x58, 0x06, 0x18, 0x80, 0x06, 0x03, 0x59, 0x06, 0x19, 0x80, 0x06, 0x01,
+    0x5a, 0x06, 0x1a, 0x5c, 0x06, 0x37, 0x80, 0x02, 0x35, 0x80, 0x02, 0x00, 0x80, 0x02, 0x33, 0x41,
+    0x02, 0x01, 0x80, 0x02, 0x31, 0x42, 0x02, 0x02, 0x80, 0x02, 0x2f, 0x43, 0x02, 0x03, 0x80, 0x02,
+    0x2d, 0x44, 0x02, 0x04, 0x80, 0x02, 0x2b, 0x45, 0x02, 0x05, 0x80, 0x02, 0x29, 0x46, 0x02, 0x06,
+    0x80, 0x02, 0x27, 0x47, 0x02, 0x07, 0x80, 0x02, 0x25, 0x48, 0x02, 0x08, 0x80, 0x02, 0x23, 0x49,
+    0x02, 0x09, 0x80, 0x02, 0x21, 0x4a, 0x02, 0x0a, 0x80, 0x02, 0x1f, 0x4b, 0x02, 0x0b, 0x80, 0x02,
+    0x1d, 0x4c, 0x02, 0x0c, 0x80, 0x02, 0x1b, 0x4d, 0x02, 0x0d, 0x80, 0x02, 0x19, 0x4e, 0x02, 0x0e,
+    0x80, 0x02, 0x17, 0x4f, 0x02, 0x0f, 0x80, 0x02, 0x15, 0x50, 0x02, 0x10, 0x80, 0x02, 0x13, 0x51,
+    0x02, 0x11, 0x80, 0x02, 0x11, 0x52, 0x02, 0x12, 0x80, 0x02, 0x0f, 0x53, 0x02, 0x13, 0x80, 0x02,
+    0x0d, 0x54, 0x02, 0x14, 0x80, 0x02, 0x0b, 0x55, 0x02, 0x15, 0x80, 0x02, 0x09, 0x56, 0x02, 0x16,
+    0x80, 0x02, 0x07, 0x57, 0x02, 0x17, 0x80, 0x02, 0x05, 0x58, 0x02, 0x18, 0x80, 0x02, 0x03, 0x59,
+    0x02, 0x19, 0x80, 0x02, 0x01, 0x5a, 0x02, 0x1a, 0x5c, 0x02, 0x37, 0x80, 0x03, 0x35, 0x80, 0x03,
+    0x00, 0x80, 0x03, 0x33, 0x41, 0x03, 0x01, 0x80, 0x03, 0x31, 0x42, 0x03, 0x02, 0x80, 0x03, 0x2f,
+    0x43, 0x03, 0x03, 0x80, 0x03, 0x2d, 0x44, 0x03, 0x04, 0x80, 0x03, 0x2b, 0x45, 0x03, 0x05, 0x80,
+    0x03, 0x29, 0x46, 0x03, 0x06, 0x80, 0x03, 0x27, 0x47, 0x03, 0x07, 0x80, 0x03, 0x25, 0x48, 0x03,
+    0x08, 0x80, 0x03, 0x23, 0x49, 0x03, 0x09, 0x80, 0x03, 0x21, 0x4a, 0x03, 0x0a, 0x80, 0x03, 0x1f,
+    0x4b, 0x03, 0x0b, 0x80, 0x03, 0x1d, 0x4c, 0x03, 0x0c, 0x80, 0x03, 0x1b, 0x4d, 0x03, 0x0d, 0x80,
+    0x03, 0x19, 0x4e, 0x03, 0x0e, 0x80, 0x03, 0x17, 0x4f, 0x03, 0x0f, 0x80, 0x03, 0x15, 0x50, 0x03,
+    0x10, 0x80, 0x03, 0x13, 0x51, 0x03, 0x11, 0x80, 0x03, 0x11, 0x52, 0x03, 0x12, 0x80, 0x03, 0x0f,
+    0x53, 0x03, 0x13, 0x80, 0x03, 0x0d, 0x54, 0x03, 0x14, 0x80, 0x03, 0x0b, 0x55, 0x03, 0x15, 0x80,
+    0x03, 0x09, 0x56, 0x03, 0x16, 0x80, 0x03, 0x07, 0x57, 0x03, 0x17, 0x80, 0x03, 0x05, 0x58, 0x03,
+    0x18, 0x80, 0x03, 0x03, 0x59, 0x03, 0x19, 0x80, 0x03, 0x01, 0x5a, 0x03, 0x1a, 0x5c, 0x03, 0x37,
+    0x80, 0x01, 0x35, 0x80, 0x01, 0x00, 0x80, 0x01, 0x33, 0x41, 0x01, 0x01, 0x80, 0x01, 0x31, 0x42,
+    0x01, 0x02, 0x80, 0x01, 0x2f, 0x43, 0x01, 0x03, 0x80, 0x01, 0x2d, 0x44, 0x01, 0x04, 0x80, 0x01,
+    0x2b, 0x45, 0x01, 0x05, 0x80, 0x01, 0x29, 0x46, 0x01, 0x06, 0x80, 0x01, 0x27, 0x47, 0x01, 0x07,
+    0x80, 0x01, 0x25, 0x48, 0x01, 0x08, 0x80, 0x01, 0x23, 0x49, 0x01, 0x09, 0x80, 0x01, 0x21, 0x4a,
+    0x01, 0x0a, 0x80, 0x01, 0x1f, 0x4b, 0x01, 0x0b, 0x80, 0x01, 0x1d, 0x4c, 0x01, 0x0c, 0x80, 0x01,
+    0x1b, 0x4d, 0x01, 0x0d, 0x80, 0x01, 0x19, 0x4e, 0x01, 0x0e, 0x80, 0x01, 0x17, 0x4f, 0x01, 0x0f,
+    0x80, 0x01, 0x15, 0x50, 0x01, 0x10, 0x80, 0x01, 0x13, 0x51, 0x01, 0x11, 0x80, 0x01, 0x11, 0x52,
+    0x01, 0x12, 0x80, 0x01, 0x0f, 0x53, 0x01, 0x13, 0x80, 0x01, 0x0d, 0x54, 0x01, 0x14, 0x80, 0x01,
+    0x0b, 0x55, 0x01, 0x15, 0x80, 0x01, 0x09, 0x56, 0x01, 0x16, 0x80, 0x01, 0x07, 0x57, 0x01, 0x17,
+    0x80, 0x01, 0x05, 0x58, 0x01, 0x18, 0x80, 0x01, 0x03, 0x59, 0x01, 0x19, 0x80, 0x01, 0x01, 0x5a,
+    0x01, 0x1a, 0x5c, 0x01, 0x37, 0x80, 0x05, 0x35, 0x80, 0x05, 0x00, 0x80, 0x05, 0x33, 0x41, 0x05,
+    0x01, 0x80, 0x05, 0x31, 0x42, 0x05, 0x02, 0x80, 0x05, 0x2f, 0x43, 0x05, 0x03, 0x80, 0x05, 0x2d,
+    0x44, 0x05, 0x04, 0x80, 0x05, 0x2b, 0x45, 0x05, 0x05, 0x80, 0x05, 0x29, 0x46, 0x05, 0x06, 0x80,
+    0x05, 0x27, 0x47, 0x05, 0x07, 0x80, 0x05, 0x25, 0x48, 0x05, 0x08, 0x80, 0x05, 0x23, 0x49, 0x05,
+    0x09, 0x80, 0x05, 0x21, 0x4a, 0x05, 0x0a, 0x80, 0x05, 0x1f, 0x4b, 0x05, 0x0b, 0x80, 0x05, 0x1d,
+    0x4c, 0x05, 0x0c, 0x80, 0x05, 0x1b, 0x4d, 0x05, 0x0d, 0x80, 0x05, 0x19, 0x4e, 0x05, 0x0e, 0x80,
+    0x05, 0x17, 0x4f, 0x05, 0x0f, 0x80, 0x05, 0x15, 0x50, 0x05, 0x10, 0x80, 0x05, 0x13, 0x51, 0x05,
+    0x11, 0x80, 0x05, 0x11, 0x52, 0x05, 0x12, 0x80, 0x05, 0x0f, 0x53, 0x05, 0x13, 0x80, 0x05, 0x0d,
+    0x54, 0x05, 0x14, 0x80, 0x05, 0x0b, 0x55, 0x05, 0x15, 0x80, 0x05, 0x09, 0x56, 0x05, 0x16, 0x80,
+    0x05, 0x07, 0x57, 0x05, 0x17, 0x80, 0x05, 0x05, 0x58, 0x05, 0x18, 0x80, 0x05, 0x03, 0x59, 0x05,
+    0x19, 0x80, 0x05, 0x01, 0x5a, 0x05, 0x1a, 0x5c, 0x05,
+};
+
+//-----------------------------------------------------------------------------
+
+const uint8_t * const anim_table[] PROGMEM = {
+    anim_comet,
+    anim_bars,
+};
+
+const uint8_t anim_count = sizeof(anim_table) / sizeof(uint8_t *);
+
+//-----------------------------------------------------------------------------
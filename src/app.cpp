@@ -0,0 +1,247 @@
+//-----------------------------------------------------------------------------
+/*
+
+Application
+
+Key presses and received notes turn on lights and feed the effect engine,
+key presses are sent as midi notes. Used by both the firmware and the host
+build, which differ only in their stdio and lcd.
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "hal.h"
+#include "uart.h"
+#include "timer.h"
+#include "color.h"
+#include "led.h"
+#include "midi.h"
+#include "key.h"
+#include "sched.h"
+#include "idle.h"
+#include "wheel.h"
+#include "effect.h"
+#include "layer.h"
+#include "light.h"
+#include "stream.h"
+#include "tempo.h"
+#include "merge.h"
+#include "bench.h"
+#include "trace.h"
+#include "telem.h"
+#include "log.h"
+#include "ram.h"
+#include "isrprof.h"
+#include "boot.h"
+#include "app.h"
+
+//-----------------------------------------------------------------------------
+// keyboard defines
+
+// 4 octaves 36, 48, 60 (middle c), 72
+#define BASE_NOTE 36
+#define NOTE_VELOCITY 100 // 0..127
+
+// lights for received notes are turned off if no note off arrives
+#define NOTE_TIMEOUT 20000 // msec
+#define NOTE_TIMERS 8
+
+//-----------------------------------------------------------------------------
+// stuck note release for received notes
+
+static WTIMER note_timer[NOTE_TIMERS];
+
+static void note_timeout(uint8_t note) {
+    light_off(LAYER_MIDI, note);
+}
+
+// return the timer for this note, or a free timer, or 0 if none are free
+static WTIMER *note_timer_get(uint8_t note) {
+    WTIMER *free = 0;
+    for (int i = 0; i < NOTE_TIMERS; i ++) {
+        WTIMER *t = &note_timer[i];
+        if (!wheel_pending(t)) {
+            free = t;
+        } else if (t->arg == note) {
+            return t;
+        }
+    }
+    return free;
+}
+
+static void midi_on(uint8_t note, uint8_t velocity) {
+    LOG_INFO(LOG_MIDI_ON, note, velocity);
+    light_on(LAYER_MIDI, note, velocity);
+    effect_note(note, velocity, 1);
+    WTIMER *t = note_timer_get(note);
+    if (t) {
+        // a repeated note on re-arms the pending timer for the note
+        if (!wheel_pending(t)) {
+            wheel_timer_init(t, note_timeout, note);
+        }
+        wheel_add(t, NOTE_TIMEOUT);
+    }
+}
+
+static void midi_off(uint8_t note, uint8_t velocity) {
+    light_off(LAYER_MIDI, note);
+    effect_note(note, velocity, 0);
+    WTIMER *t = note_timer_get(note);
+    if (t && (t->arg == note)) {
+        wheel_cancel(t);
+    }
+}
+
+static int downs;
+
+static int key_to_midi(uint8_t key) {
+    return white_to_midi(key) + ((key / WHITE_KEYS_IN_OCTAVE) * NOTES_IN_OCTAVE) + BASE_NOTE;
+}
+
+static void key_down(uint8_t key) {
+    downs += 1;
+    uint8_t note = key_to_midi(key);
+    LOG_INFO(LOG_KEY_DOWN, note, downs);
+    light_on(LAYER_KEYS, note, NOTE_VELOCITY);
+    effect_note(note, NOTE_VELOCITY, 1);
+    midi_tx(NOTE_ON, note, NOTE_VELOCITY);
+}
+
+static void key_up(uint8_t key) {
+    uint8_t note = key_to_midi(key);
+    LOG_INFO(LOG_KEY_UP, note, 0);
+    light_off(LAYER_KEYS, note);
+    effect_note(note, NOTE_VELOCITY, 0);
+    midi_tx(NOTE_OFF, note, NOTE_VELOCITY);
+}
+
+//-----------------------------------------------------------------------------
+// tasks
+
+// parse all buffered midi input
+static void midi_task(void) {
+    while (uart_test_rx()) {
+        midi_rx();
+    }
+}
+
+// device sysex: frame streaming, the trace and telemetry requests
+static void app_sysex(uint8_t c) {
+    stream_sysex(c);
+    trace_sysex(c);
+    telem_sysex(c);
+}
+
+// replies to the device sysex requests, one task for both
+static int reply_pending(void) {
+    return trace_pending() || telem_pending();
+}
+
+static void reply_task(void) {
+    trace_run();
+    telem_run();
+}
+
+// forward realtime bytes, track the clock
+static void midi_realtime(uint8_t c) {
+    merge_realtime(c);
+    tempo_rx(c);
+}
+
+// once per led frame: step the key lights, render the effect, compose
+static uint8_t frame_seen;
+
+static int frame_pending(void) {
+    return led_frame_count() != frame_seen;
+}
+
+static void frame_task(void) {
+    BENCH_BEGIN(BENCH_FRAME);
+    frame_seen = led_frame_count();
+    TRACE(TRACE_FRAME_START, frame_seen, 0);
+    int changed = light_render();
+    changed |= effect_render(timer_get_msec());
+    if (changed) {
+        layer_compose(0, NUM_LEDS);
+    }
+    TRACE(TRACE_FRAME_END, frame_seen, changed);
+    BENCH_END(BENCH_FRAME);
+}
+
+//-----------------------------------------------------------------------------
+
+// scheduler idle: print the queued log, sleep when there is none
+void app_idle(void) {
+    if (!log_run()) {
+        idle_sleep();
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Boot order: the keys, midi and leds first, the piano is playable as soon
+// as the scheduler starts. The application's tasks go in last. The firmware and the host build run the same
+// table (the host stops on any failure).
+
+static const BOOT_STEP boot_steps[] PROGMEM = {
+    {timer_init, "timer", BOOT_REQUIRED},
+    {sched_init, "sched", BOOT_REQUIRED},
+    {wheel_init, "wheel", 0},
+    {uart_init, "uart", 0},
+    {midi_init, "midi", 0},
+    {merge_init, "merge", 0},
+    {key_init, "key", 0},
+    {led_init, "led", 0},
+    {layer_init, "layer", 0},
+    {light_init, "light", 0},
+    {effect_init, "effect", 0},
+    {tempo_init, "tempo", 0},
+    {log_init, "log", 0},
+    {trace_init, "trace", 0},
+    {telem_init, "telem", 0},
+    {ram_init, "ram", 0},
+#if defined(ISR_PROFILE)
+    {isrprof_init, "isrprof", 0},
+#endif
+    {idle_init, "idle", 0},
+    {app_init, "app", 0},
+};
+
+// init the modules, return non-zero if a required one failed
+int app_boot(void) {
+    return boot_run(boot_steps, sizeof(boot_steps) / sizeof(BOOT_STEP));
+}
+
+//-----------------------------------------------------------------------------
+
+int app_init(void) {
+    downs = 0;
+
+    // actions on key presses
+    keys.key_down = key_down;
+    keys.key_up = key_up;
+
+    // actions on midi rx
+    midi.note_on = midi_on;
+    midi.note_off = midi_off;
+    midi.program_change = effect_program;
+    midi.sysex = app_sysex;
+    midi.realtime = midi_realtime;
+    midi.message = merge_message;
+
+    // 1 ms scan period, 7 rows: each key is sampled every 7 ms
+    if ((sched_add(key_scan, 0, 1, SCHED_PRIO_SCAN) < 0) ||
+        (sched_add_event(midi_task, uart_test_rx, SCHED_PRIO_MIDI) < 0) ||
+        (sched_add_event(merge_run, merge_pending, SCHED_PRIO_MIDI) < 0) ||
+        (sched_add_event(reply_task, reply_pending, SCHED_PRIO_MIDI) < 0) ||
+        (sched_add(wheel_run, 0, WHEEL_TICK_MSEC, SCHED_PRIO_TIMER) < 0) ||
+        (sched_add_event(frame_task, frame_pending, SCHED_PRIO_LED) < 0)) {
+        // out of task slots (SCHED_MAX_TASKS)
+        return -1;
+    }
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
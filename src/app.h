@@ -0,0 +1,26 @@
+//-----------------------------------------------------------------------------
+/*
+
+Application
+
+The key, midi and led frame handling shared by the firmware (main.cpp) and
+the host build (host.cpp).
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef APP_H
+#define APP_H
+
+//-----------------------------------------------------------------------------
+// API functions
+
+int app_boot(void);
+int app_init(void);
+void app_idle(void);
+
+//-----------------------------------------------------------------------------
+
+#endif // APP_H
+
+//-----------------------------------------------------------------------------
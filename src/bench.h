@@ -0,0 +1,59 @@
+//-----------------------------------------------------------------------------
+/*
+
+Benchmark Probes
+
+With BENCH defined ("make bench") the probes write an id to GPIOR0 as a
+function starts and the id with bit 7 set as it ends. The simavr harness
+in tools/simbench watches the register and turns the writes into cycle
+counts. Each probe is a single "out" (1 cycle).
+
+Otherwise the probes compile to nothing.
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef BENCH_H
+#define BENCH_H
+
+//-----------------------------------------------------------------------------
+// probe ids (0x01..0x7f, the names are in tools/simbench/simbench.c)
+
+// tasks
+#define BENCH_KEY_SCAN          0x01
+#define BENCH_MIDI_RX           0x02
+#define BENCH_FRAME             0x03
+
+// isrs
+#define BENCH_UART_RX_ISR       0x10
+#define BENCH_UART_TX_ISR       0x11
+#define BENCH_LED_ISR           0x12
+#define BENCH_TIMER_OVF_ISR     0x13
+#define BENCH_TIMER_ALARM_ISR   0x14
+
+// effect render functions, by effect index
+#define BENCH_EFFECT(idx)       (0x40 + ((idx) & 0x3f))
+
+#define BENCH_END_FLAG          0x80
+
+//-----------------------------------------------------------------------------
+
+#if defined(BENCH) && defined(__AVR__)
+
+#include <avr/io.h>
+
+#define BENCH_BEGIN(id) (GPIOR0 = (id))
+#define BENCH_END(id) (GPIOR0 = (id) | BENCH_END_FLAG)
+
+#else
+
+#define BENCH_BEGIN(id)
+#define BENCH_END(id)
+
+#endif
+
+//-----------------------------------------------------------------------------
+
+#endif // BENCH_H
+
+//-----------------------------------------------------------------------------
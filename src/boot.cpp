@@ -0,0 +1,65 @@
+//-----------------------------------------------------------------------------
+/*
+
+Boot Sequencer
+
+Runs a table of init functions in order. The table puts the modules the
+piano needs to be played (timer, scheduler, uart, midi, keys, leds) first
+and the rest after, and no init function may wait: the lcd's power on
+delays run later from lcd_flush().
+
+The table lives in program memory, names and all. A failed step is
+shown on the lcd (the shadow display is up from the start, its output
+appears once the device is ready) and counted, the rest of the firmware
+runs without that module. Setup after the table (main.cpp's own tasks)
+counts its failures with boot_fail() the same way. Only a failed
+BOOT_REQUIRED step (there is no scheduler without the timer) stops the
+boot.
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hal.h"
+#include "timer.h"
+#include "boot.h"
+
+//-----------------------------------------------------------------------------
+
+BOOT_CTRL boot;
+
+//-----------------------------------------------------------------------------
+
+// count and show a failed step (name in program space)
+void boot_fail(const char *name) {
+    boot.fails ++;
+    putc('\n', stdout);
+    fputs_P(name, stdout);
+    fputs_P(PSTR(" fail"), stdout);
+}
+
+// run the steps, return non-zero if a required step failed
+int boot_run(const BOOT_STEP *steps, uint8_t n) {
+    for (uint8_t i = 0; i < n; i ++) {
+        BOOT_STEP s;
+        memcpy_P(&s, &steps[i], sizeof(BOOT_STEP));
+        if (s.init() == 0) {
+            continue;
+        }
+        boot_fail(steps[i].name);
+        if (s.flags & BOOT_REQUIRED) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// the application is running
+void boot_ready(void) {
+    boot.ready_usec = timer_get_usec();
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,47 @@
+//-----------------------------------------------------------------------------
+/*
+
+Boot Sequencer
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef BOOT_H
+#define BOOT_H
+
+//-----------------------------------------------------------------------------
+
+// flags
+#define BOOT_REQUIRED   (1 << 0)    // nothing can run without it
+
+//-----------------------------------------------------------------------------
+
+typedef struct boot_step {
+
+    int (*init)(void);      // returns 0 on success
+    char name[8];
+    uint8_t flags;
+
+} BOOT_STEP;
+
+typedef struct boot_control {
+
+    uint8_t fails;          // steps that failed
+    uint32_t ready_usec;    // timer usecs when the application started
+
+} BOOT_CTRL;
+
+extern BOOT_CTRL boot;
+
+//-----------------------------------------------------------------------------
+// API functions
+
+int boot_run(const BOOT_STEP *steps, uint8_t n);
+void boot_fail(const char *name);
+void boot_ready(void);
+
+//-----------------------------------------------------------------------------
+
+#endif // BOOT_H
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,160 @@
+//-----------------------------------------------------------------------------
+/*
+
+Cellular Automata
+
+The cell state is a packed 64 bit bitset and a whole generation is computed
+with word wide logic operations - there is no per cell loop.
+
+1D: the left, centre and right neighbours of every cell are the bitset
+rotated by one each way. The rule is a function of these 3 bits, which is
+evaluated as a tree of 3 multiplexers: the 4 leaves, each a function of the
+right neighbour only, are picked from {0, ~R, R, ~0} by looking up pairs of
+rule bits.
+
+2D: the 8 neighbour bitsets are shifts of the state with wrap around at
+the edges of the grid (a torus). They are summed with bit sliced adders
+into a 4 bit count per cell, and the birth/survive rules select the new
+state from the count.
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+
+#include "ca.h"
+
+//-----------------------------------------------------------------------------
+
+// return a where s is 1, b where s is 0
+static inline uint64_t mux(uint64_t s, uint64_t a, uint64_t b) {
+    return b ^ (s & (a ^ b));
+}
+
+static uint64_t ca_mask(uint8_t n) {
+    return (n >= 64) ? ~0ULL : ((1ULL << n) - 1);
+}
+
+//-----------------------------------------------------------------------------
+// 1D
+
+void ca1d_init(CA1D *ca, uint8_t n, uint8_t rule) {
+    memset(ca, 0, sizeof(CA1D));
+    if (n > CA_MAX_CELLS) {
+        n = CA_MAX_CELLS;
+    }
+    ca->n = n;
+    ca->rule = rule;
+    ca->all = ca_mask(n);
+}
+
+void ca1d_step(CA1D *ca, uint8_t generations) {
+    uint64_t s = ca->cells;
+    uint64_t all = ca->all;
+    uint8_t n = ca->n;
+    uint8_t rule = ca->rule;
+
+    while (generations --) {
+        // bit i of l/r = cell i-1/i+1
+        uint64_t l = ((s << 1) | (s >> (n - 1))) & all;
+        uint64_t r = ((s >> 1) | (s << (n - 1))) & all;
+        uint64_t leaf[4];
+        for (uint8_t i = 0; i < 4; i ++) {
+            // rule bits for lc = i, r = 0 and r = 1
+            switch ((rule >> (i << 1)) & 3) {
+                case 0: leaf[i] = 0; break;
+                case 1: leaf[i] = ~r; break;
+                case 2: leaf[i] = r; break;
+                default: leaf[i] = ~0ULL; break;
+            }
+        }
+        uint64_t c0 = mux(s, leaf[1], leaf[0]);
+        uint64_t c1 = mux(s, leaf[3], leaf[2]);
+        s = mux(l, c1, c0) & all;
+    }
+    ca->cells = s;
+}
+
+//-----------------------------------------------------------------------------
+// 2D
+
+void ca2d_init(CA2D *ca, uint8_t w, uint8_t h, uint16_t birth, uint16_t survive) {
+    memset(ca, 0, sizeof(CA2D));
+    if ((w * h) > CA_MAX_CELLS) {
+        h = CA_MAX_CELLS / w;
+    }
+    ca->w = w;
+    ca->h = h;
+    ca->birth = birth;
+    ca->survive = survive;
+    ca->all = ca_mask(w * h);
+    for (uint8_t y = 0; y < h; y ++) {
+        ca->first |= 1ULL << (y * w);
+        ca->last |= 1ULL << ((y * w) + w - 1);
+    }
+}
+
+// bit i = west neighbour of cell i
+static inline uint64_t west(const CA2D *ca, uint64_t s) {
+    return ((s << 1) & ~ca->first) | ((s >> (ca->w - 1)) & ca->first);
+}
+
+// bit i = east neighbour of cell i
+static inline uint64_t east(const CA2D *ca, uint64_t s) {
+    return ((s >> 1) & ~ca->last) | ((s << (ca->w - 1)) & ca->last);
+}
+
+void ca2d_step(CA2D *ca, uint8_t generations) {
+    uint64_t s = ca->cells;
+    uint8_t n = ca->w * ca->h;
+
+    while (generations --) {
+        uint64_t nb[8];
+        // bit i = north/south neighbour of cell i
+        uint64_t north = ((s << ca->w) | (s >> (n - ca->w))) & ca->all;
+        uint64_t south = ((s >> ca->w) | (s << (n - ca->w))) & ca->all;
+        nb[0] = north;
+        nb[1] = south;
+        nb[2] = west(ca, s);
+        nb[3] = east(ca, s);
+        nb[4] = west(ca, north);
+        nb[5] = east(ca, north);
+        nb[6] = west(ca, south);
+        nb[7] = east(ca, south);
+
+        // bit sliced sum: count = c3 c2 c1 c0
+        uint64_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+        for (uint8_t i = 0; i < 8; i ++) {
+            uint64_t k0 = c0 & nb[i];
+            c0 ^= nb[i];
+            uint64_t k1 = c1 & k0;
+            c1 ^= k0;
+            uint64_t k2 = c2 & k1;
+            c2 ^= k1;
+            c3 |= k2;
+        }
+
+        uint64_t next = 0;
+        for (uint8_t k = 0; k <= 8; k ++) {
+            uint8_t b = (ca->birth >> k) & 1;
+            uint8_t v = (ca->survive >> k) & 1;
+            if ((b | v) == 0) {
+                continue;
+            }
+            uint64_t eq = ((k & 1) ? c0 : ~c0) & ((k & 2) ? c1 : ~c1) &
+                ((k & 4) ? c2 : ~c2) & ((k & 8) ? c3 : ~c3);
+            if (b && v) {
+                next |= eq;
+            } else if (v) {
+                next |= eq & s;
+            } else {
+                next |= eq & ~s;
+            }
+        }
+        s = next & ca->all;
+    }
+    ca->cells = s;
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,57 @@
+//-----------------------------------------------------------------------------
+/*
+
+Cellular Automata
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef CA_H
+#define CA_H
+
+//-----------------------------------------------------------------------------
+
+#define CA_MAX_CELLS 64
+
+// 1D elementary automaton: ring of n cells, rule 0..255
+typedef struct ca1d {
+
+    uint64_t cells;     // bit i = cell i
+    uint64_t all;       // mask of the n cells
+    uint8_t n;
+    uint8_t rule;
+
+} CA1D;
+
+// 2D life-like automaton: w x h torus, birth/survive rules
+typedef struct ca2d {
+
+    uint64_t cells;     // bit (y * w + x) = cell x,y
+    uint64_t all;       // mask of the w * h cells
+    uint64_t first;     // mask of the column x = 0
+    uint64_t last;      // mask of the column x = w - 1
+    uint16_t birth;     // bit k: dead cell with k neighbours is born
+    uint16_t survive;   // bit k: live cell with k neighbours survives
+    uint8_t w;
+    uint8_t h;
+
+} CA2D;
+
+// conway's life, B3/S23
+#define CA_LIFE_BIRTH   (1 << 3)
+#define CA_LIFE_SURVIVE ((1 << 2) | (1 << 3))
+
+//-----------------------------------------------------------------------------
+// API functions
+
+void ca1d_init(CA1D *ca, uint8_t n, uint8_t rule);
+void ca1d_step(CA1D *ca, uint8_t generations);
+
+void ca2d_init(CA2D *ca, uint8_t w, uint8_t h, uint16_t birth, uint16_t survive);
+void ca2d_step(CA2D *ca, uint8_t generations);
+
+//-----------------------------------------------------------------------------
+
+#endif // CA_H
+
+//-----------------------------------------------------------------------------
@@ -12,8 +12,10 @@ Common Definitions
 //-----------------------------------------------------------------------------
 // Re-define PROGMEM (http://gcc.gnu.org/bugzilla/show_bug.cgi?id=34734)
 
+#if defined(__AVR__)
 #undef PROGMEM
 #define PROGMEM __attribute__((section(".progmem.data")))
+#endif
 
 //-----------------------------------------------------------------------------
 
@@ -23,12 +25,6 @@ Common Definitions
 
 //-----------------------------------------------------------------------------
 
-#define INIT(function) \
-    if (function() != 0) { \
-        printf_P(PSTR("%s(): fail\n"), #function); \
-        init_fails += 1; \
-    }
-
 #define inc_mod(a, b) ((a + 1) & b)
 
 //-----------------------------------------------------------------------------
@@ -3,69 +3,90 @@
 
 Demo Code
 
+LED effects for the effect engine. Each effect renders into the frame it is
+given. State that must persist between frames lives in the shared effect
+memory, so only the running effect uses any SRAM.
+
 */
 //-----------------------------------------------------------------------------
 
-static int demo_done;
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "hal.h"
+#include "common.h"
+#include "color.h"
+#include "led.h"
+#include "midi.h"
+#include "effect.h"
+#include "ca.h"
+#include "diffuse.h"
+#include "anim.h"
+#include "stream.h"
+#include "tempo.h"
 
-static void done_check(uint8_t note, uint8_t velocity) {
-    if (note == MODE_NOTE) {
-        demo_done = 1;
-    }
-}
+//-----------------------------------------------------------------------------
+
+static const RGB note2color[WHITE_KEYS_IN_OCTAVE] PROGMEM = {
+    COLOR_RED,
+    COLOR_GREEN,
+    COLOR_BLUE,
+    COLOR_YELLOW,
+    COLOR_AQUA,
+    COLOR_FUCHSIA,
+    COLOR_WHITE
+};
 
 //-----------------------------------------------------------------------------
 // demo - all leds set to white
 
-static void demo_all_white(void) {
-    printf_P(PSTR("\nall white"));
-    midi.note_on = done_check;
-    midi.note_off = 0;
+static void all_white_init(RGB *frame, uint8_t arg) {
     RGB white = COLOR_WHITE;
-
     for (int i = 0; i < NUM_LEDS; i ++) {
-        led_set(i, &white);
-    }
-
-    while (!demo_done) {
-        timer_delay_msec_poll(20, midi_rx);
+        frame[i] = white;
     }
-
-    led_all_off();
-    demo_done = 0;
 }
 
 //-----------------------------------------------------------------------------
 // demo - all leds at once, spectrum of rgb colors
 
-static void demo_spectrum(void) {
-    printf_P(PSTR("\nled spectrum"));
-    midi.note_on = done_check;
-    midi.note_off = 0;
+typedef struct spectrum_state {
+    uint32_t last;
+    float w;
+    float inc;
+} SPECTRUM_STATE;
 
-    float w = 380.0;
-    int inc = 1.0;
+EFFECT_STATE_CHECK(SPECTRUM_STATE);
 
-    while (!demo_done) {
-        RGB rgb;
-        for (int i = 0; i < NUM_LEDS; i ++) {
-            led_set(i, wavelength_to_rgb(&rgb, w));
-        }
-        w += inc;
-        if ((w > 780.0) || (w < 380.0)) {
-            inc *= -1;
-        }
-        if (w > 780.0) {
-            w = 780.0;
-        }
-        if (w < 380.0) {
-            w = 380.0;
-        }
-        timer_delay_msec_poll(10, midi_rx);
-    }
+static void spectrum_init(RGB *frame, uint8_t arg) {
+    SPECTRUM_STATE *st = EFFECT_STATE(SPECTRUM_STATE);
+    st->w = 380.0;
+    st->inc = 1.0;
+}
 
-    led_all_off();
-    demo_done = 0;
+static int spectrum_render(RGB *frame, uint32_t t) {
+    SPECTRUM_STATE *st = EFFECT_STATE(SPECTRUM_STATE);
+    if (!effect_step(&st->last, t, 10)) {
+        return 0;
+    }
+    RGB rgb;
+    wavelength_to_rgb(&rgb, st->w);
+    for (int i = 0; i < NUM_LEDS; i ++) {
+        frame[i] = rgb;
+    }
+    st->w += st->inc;
+    if ((st->w > 780.0) || (st->w < 380.0)) {
+        st->inc *= -1;
+    }
+    if (st->w > 780.0) {
+        st->w = 780.0;
+    }
+    if (st->w < 380.0) {
+        st->w = 380.0;
+    }
+    return 1;
 }
 
 //-----------------------------------------------------------------------------
@@ -84,311 +105,381 @@ static float scroll_function(float x) {
     }
 }
 
-static void demo_spectrum_scroll(void) {
-    printf_P(PSTR("\nspectrum scroll"));
-    midi.note_on = done_check;
-    midi.note_off = 0;
-
-    float w = 0;
-    float inc = 0.2;
+static void spectrum_scroll_init(RGB *frame, uint8_t arg) {
+    SPECTRUM_STATE *st = EFFECT_STATE(SPECTRUM_STATE);
+    st->w = 0;
+    st->inc = 0.2;
+}
 
-    while (!demo_done) {
-        RGB rgb;
-        for (int i = 0; i < NUM_LEDS; i ++) {
-            led_set(i, wavelength_to_rgb(&rgb, scroll_function(w + float(i))));
-        }
-        w += inc;
-        timer_delay_msec_poll(10, midi_rx);
+static int spectrum_scroll_render(RGB *frame, uint32_t t) {
+    SPECTRUM_STATE *st = EFFECT_STATE(SPECTRUM_STATE);
+    if (!effect_step(&st->last, t, 10)) {
+        return 0;
     }
-
-    led_all_off();
-    demo_done = 0;
+    for (int i = 0; i < NUM_LEDS; i ++) {
+        wavelength_to_rgb(&frame[i], scroll_function(st->w + float(i)));
+    }
+    st->w += st->inc;
+    return 1;
 }
 
 //-----------------------------------------------------------------------------
 // demo - led chase 1
 
-static void demo_chase1(void) {
-    printf_P(PSTR("\nled chase 1"));
-    midi.note_on = done_check;
-    midi.note_off = 0;
+typedef struct chase_state {
+    uint32_t last;
+    int posn;
+    int inc;
+} CHASE_STATE;
 
-    int posn, inc;
+EFFECT_STATE_CHECK(CHASE_STATE);
+
+static void chase1_init(RGB *frame, uint8_t arg) {
+    CHASE_STATE *st = EFFECT_STATE(CHASE_STATE);
+    st->posn = 1;
+    st->inc = -1;
+}
+
+static int chase1_render(RGB *frame, uint32_t t) {
+    CHASE_STATE *st = EFFECT_STATE(CHASE_STATE);
     RGB bg = COLOR_BLUE;
     RGB fg = COLOR_RED;
-    posn = 1;
-    inc = -1;
-
-    while (!demo_done) {
-        led_set(posn, &bg);
-        posn += inc;
-        if (posn == (NUM_LEDS - 1)) {
-            // end of the string - go backwards
-            inc = -1;
-        }
-        if (posn == 0) {
-            // start of the string - go forward
-            inc = 1;
-        }
-        led_set(posn, &fg);
-        timer_delay_msec_poll(40, midi_rx);
+    if (!effect_step(&st->last, t, 40)) {
+        return 0;
     }
-
-    led_all_off();
-    demo_done = 0;
+    frame[st->posn] = bg;
+    st->posn += st->inc;
+    if (st->posn == (NUM_LEDS - 1)) {
+        // end of the string - go backwards
+        st->inc = -1;
+    }
+    if (st->posn == 0) {
+        // start of the string - go forward
+        st->inc = 1;
+    }
+    frame[st->posn] = fg;
+    return 1;
 }
 
 //-----------------------------------------------------------------------------
 // demo - led chase 2
 
-static void demo_chase2(void) {
-    printf_P(PSTR("\nled chase 2"));
-    midi.note_on = done_check;
-    midi.note_off = 0;
-    int ofs = 0;
-
-    while (!demo_done) {
-        for (int i = 0; i < NUM_LEDS; i ++) {
-            RGB rgb;
-            uint8_t mag = i * (255 / (NUM_LEDS - 1));
-            rgb.r = mag;
-            rgb.g = (255 - mag);
-            rgb.b = mag >> 3;
-            led_set((i + ofs) % NUM_LEDS, &rgb);
-        }
-        ofs += 1;
-        timer_delay_msec_poll(40, midi_rx);
+static int chase2_render(RGB *frame, uint32_t t) {
+    CHASE_STATE *st = EFFECT_STATE(CHASE_STATE);
+    if (!effect_step(&st->last, t, 40)) {
+        return 0;
     }
-
-    led_all_off();
-    demo_done = 0;
+    for (int i = 0; i < NUM_LEDS; i ++) {
+        RGB *rgb = &frame[(i + st->posn) % NUM_LEDS];
+        uint8_t mag = i * (255 / (NUM_LEDS - 1));
+        rgb->r = mag;
+        rgb->g = (255 - mag);
+        rgb->b = mag >> 3;
+    }
+    st->posn += 1;
+    return 1;
 }
 
 //-----------------------------------------------------------------------------
 // demo - led chase 3
 
-static void demo_chase3(void) {
-    printf_P(PSTR("\nled chase 3"));
-    midi.note_on = done_check;
-    midi.note_off = 0;
-    int loop = 0;
-
-    while (!demo_done) {
-        RGB next[NUM_LEDS];
-
-        zero_rgb(&next[0]);
-
-        // copy all leds to the next position
-        for (int i = 1; i < NUM_LEDS; i ++) {
-            copy_rgb(&next[i], led_get(i - 1));
-        }
+static int chase3_render(RGB *frame, uint32_t t) {
+    CHASE_STATE *st = EFFECT_STATE(CHASE_STATE);
+    if (!effect_step(&st->last, t, 40)) {
+        return 0;
+    }
 
-        // add an attenuation of the previous value
-        for (int i = 0; i < NUM_LEDS; i ++) {
-            RGB rgb;
-            copy_rgb(&rgb, led_get(i));
-            scale_rgb(&rgb, 0.1);
-            add_rgb(&next[i], &rgb);
+    // move all leds to the next position and add an attenuation (~0.1) of
+    // the previous value. work down the string so it can be done in place.
+    for (int i = NUM_LEDS - 1; i >= 0; i --) {
+        RGB rgb;
+        if (i > 0) {
+            copy_rgb(&rgb, &frame[i - 1]);
+        } else {
+            zero_rgb(&rgb);
         }
+        frame[i].r = (frame[i].r * 26) >> 8;
+        frame[i].g = (frame[i].g * 26) >> 8;
+        frame[i].b = (frame[i].b * 26) >> 8;
+        add_rgb(&frame[i], &rgb);
+    }
 
-        if ((loop % 30) == 0) {
-            random_rgb(&next[0]);
-        }
+    if ((st->posn % 30) == 0) {
+        random_rgb(&frame[0]);
+    }
+    st->posn += 1;
+    return 1;
+}
 
-        for (int i = 0; i < NUM_LEDS; i ++) {
-            led_set(i, &next[i]);
-        }
+//-----------------------------------------------------------------------------
 
-        loop += 1;
-        timer_delay_msec_poll(40, midi_rx);
+static int random_render(RGB *frame, uint32_t t) {
+    CHASE_STATE *st = EFFECT_STATE(CHASE_STATE);
+    if (!effect_step(&st->last, t, 40)) {
+        return 0;
     }
-
-    led_all_off();
-    demo_done = 0;
+    for (int i = 0; i < (NUM_LEDS / 7); i ++) {
+        random_rgb(&frame[rand() % NUM_LEDS]);
+    }
+    return 1;
 }
 
 //-----------------------------------------------------------------------------
 
-static void demo_random(void) {
-    printf_P(PSTR("\nled random"));
-    midi.note_on = done_check;
-    midi.note_off = 0;
+typedef struct automata_state {
+    uint32_t last;
+    RGB bg;
+    CA1D ca;
+} AUTOMATA_STATE;
+
+EFFECT_STATE_CHECK(AUTOMATA_STATE);
 
-    while (!demo_done) {
+static void automata_init(RGB *frame, uint8_t rule) {
+    AUTOMATA_STATE *st = EFFECT_STATE(AUTOMATA_STATE);
+    ca1d_init(&st->ca, NUM_LEDS, rule);
+    st->ca.cells = 1ULL << (NUM_LEDS / 2);
+    random_rgb(&st->bg);
+}
 
-        for (int i = 0; i < (NUM_LEDS / 7); i ++) {
-            int posn = rand() % NUM_LEDS;
-            RGB rgb;
-            led_set(posn, random_rgb(&rgb));
-        }
-        timer_delay_msec_poll(40, midi_rx);
+static int automata_render(RGB *frame, uint32_t t) {
+    AUTOMATA_STATE *st = EFFECT_STATE(AUTOMATA_STATE);
+    RGB fg = COLOR_BLACK;
+
+    if (!effect_step(&st->last, t, 500)) {
+        return 0;
     }
+    ca1d_step(&st->ca, 1);
 
-    led_all_off();
-    demo_done = 0;
+    // render the state on the leds
+    uint64_t cells = st->ca.cells;
+    for (int i = 0; i < NUM_LEDS; i ++) {
+        frame[i] = (cells & 1) ? fg : st->bg;
+        cells >>= 1;
+    }
+    return 1;
 }
 
 //-----------------------------------------------------------------------------
+// demo - 2D life on the key grid (7 keys wide, one row per octave)
 
-static void demo_automata(int rule) {
-    printf_P(PSTR("\nled automata %d"), rule);
-    midi.note_on = done_check;
-    midi.note_off = 0;
-    RGB bg;
-    RGB fg = COLOR_BLACK;
+typedef struct life_state {
+    uint32_t last;
+    uint64_t prev;
+    CA2D ca;
+} LIFE_STATE;
+
+EFFECT_STATE_CHECK(LIFE_STATE);
+
+// rand() gives 15 bits on the AVR (RAND_MAX 0x7FFF), two cover the 28 cells
+static void life_seed(LIFE_STATE *st) {
+    st->ca.cells = (((uint64_t)rand() << 15) | rand()) & st->ca.all;
+}
 
-    random_rgb(&bg);
-
-    uint8_t state[NUM_LEDS];
-    memset(state, 0, sizeof(state));
-    state[NUM_LEDS/2] = 1;
-
-    while (!demo_done) {
-
-        // work out the next state
-        uint8_t next_state[NUM_LEDS];
-        for (int i = 0; i < NUM_LEDS; i ++) {
-            int n = 0;
-            if (i == 0) {
-                n = (state[NUM_LEDS - 1] << 2) | (state[0] << 1) | state[1];
-            } else if (i == NUM_LEDS - 1) {
-                n = (state[NUM_LEDS - 2] << 2) | (state[NUM_LEDS - 1] << 1) | state[0];
-            } else {
-                n = (state[i -1] << 2) | (state[i] << 1) | state[i + 1];
-            }
-
-            if (rule & (1 << n)) {
-                next_state[i] = 1;
-            } else {
-                next_state[i] = 0;
-            }
+static void life_init(RGB *frame, uint8_t arg) {
+    LIFE_STATE *st = EFFECT_STATE(LIFE_STATE);
+    ca2d_init(&st->ca, WHITE_KEYS_IN_OCTAVE, NUM_LEDS / (LEDS_PER_KEY * WHITE_KEYS_IN_OCTAVE),
+        CA_LIFE_BIRTH, CA_LIFE_SURVIVE);
+    life_seed(st);
+}
+
+static int life_render(RGB *frame, uint32_t t) {
+    LIFE_STATE *st = EFFECT_STATE(LIFE_STATE);
+
+    if (!effect_step(&st->last, t, 250)) {
+        return 0;
+    }
+    uint64_t prev = st->ca.cells;
+    ca2d_step(&st->ca, 1);
+    if ((st->ca.cells == prev) || (st->ca.cells == st->prev)) {
+        // dead, still or blinking - start again
+        life_seed(st);
+    }
+    st->prev = prev;
+
+    // one cell per key
+    uint64_t cells = st->ca.cells;
+    for (int i = 0; i < NUM_LEDS; i += LEDS_PER_KEY) {
+        RGB rgb = COLOR_BLACK;
+        if (cells & 1) {
+            memcpy_P(&rgb, &note2color[(i / LEDS_PER_KEY) % WHITE_KEYS_IN_OCTAVE], sizeof(RGB));
         }
-        // copy to current state
-        memcpy(state, next_state, sizeof(state));
-
-        // render the state on the leds
-        for (int i = 0; i < NUM_LEDS; i ++) {
-            if (state[i]) {
-                led_set(i, &fg);
-            } else {
-                led_set(i, &bg);
-            }
+        for (int j = 0; j < LEDS_PER_KEY; j ++) {
+            frame[i + j] = rgb;
         }
-        timer_delay_msec_poll(500, midi_rx);
+        cells >>= 1;
     }
-
-    led_all_off();
-    demo_done = 0;
+    return 1;
 }
 
 //-----------------------------------------------------------------------------
 // demo - color piano
 
-static const RGB note2color[WHITE_KEYS_IN_OCTAVE] = {
-    COLOR_RED,
-    COLOR_GREEN,
-    COLOR_BLUE,
-    COLOR_YELLOW,
-    COLOR_AQUA,
-    COLOR_FUCHSIA,
-    COLOR_WHITE
-};
+static void note_ctrl(RGB *frame, uint8_t note, int on_flag) {
+    int led_num = led_note_index(note);
+    if (led_num < 0) {
+        return;
+    }
+    RGB rgb = COLOR_BLACK;
+    if (on_flag) {
+        memcpy_P(&rgb, &note2color[midi_to_white(note)], sizeof(RGB));
+    }
+    for (int i = 0; i < LEDS_PER_KEY; i ++) {
+        frame[led_num + i] = rgb;
+    }
+}
 
-static void note_ctrl(uint8_t note, uint8_t velocity, int on_flag) {
-    int white_note = midi_note_to_white(note);
-    int octave = midi_note_to_octave(note);
+static void light_ctrl(RGB *frame, uint8_t note, uint8_t velocity, int on_flag) {
+    note_ctrl(frame, note, on_flag);
+}
 
-    if ((white_note >= 0) && (octave >= START_OCTAVE)) {
-        octave -= START_OCTAVE;
-        int led_num = NUM_LEDS - 1 - (octave * 7) - white_note;
+//-----------------------------------------------------------------------------
 
-        if (on_flag) {
-            // turn on light
-            led_set(led_num, (RGB *)&note2color[white_note]);
-        } else {
-            // turn off light
-            RGB black = COLOR_BLACK;
-            led_set(led_num, &black);
-        }
+static void light_drop(RGB *frame, uint8_t note, uint8_t velocity, int on_flag) {
+    if (on_flag) {
+        note_ctrl(frame, note, 1);
     }
 }
 
-static void light_on(uint8_t note, uint8_t velocity) {
-    char tmp[8];
-    printf_P(PSTR("\n%s %d %d"), midi_full_note_name(tmp, note), note, velocity);
-    done_check(note, velocity);
-    note_ctrl(note, velocity, 1);
-}
+// close to the original 3 led box blur spread at 25 Hz, now every frame
+static const DIFFUSE_KERNEL blur_kernel PROGMEM = {1, {1, 6, 1}, 3, 0, 1};
 
-static void light_off(uint8_t note, uint8_t velocity) {
-    note_ctrl(note, velocity, 0);
+static int color_piano2_render(RGB *frame, uint32_t t) {
+    DIFFUSE_KERNEL k;
+    memcpy_P(&k, &blur_kernel, sizeof(k));
+    diffuse(frame, NUM_LEDS, &k);
+    return 1;
 }
 
-static void demo_color_piano(void) {
-    printf_P(PSTR("\ncolor piano"));
-    midi.note_on = light_on;
-    midi.note_off = light_off;
+//-----------------------------------------------------------------------------
+// demo - ripple: key presses spread out along the keyboard and fade
 
-    while (!demo_done) {
-        midi_rx();
-    }
+static const DIFFUSE_KERNEL ripple_kernel PROGMEM = {2, {1, 4, 6, 4, 1}, 4, 5, 0};
 
-    led_all_off();
-    demo_done = 0;
+static int ripple_render(RGB *frame, uint32_t t) {
+    DIFFUSE_KERNEL k;
+    memcpy_P(&k, &ripple_kernel, sizeof(k));
+    diffuse(frame, NUM_LEDS, &k);
+    return 1;
 }
 
 //-----------------------------------------------------------------------------
+// demo - animation played from program memory (arg = anim_table index)
+
+typedef struct anim_state {
+    uint32_t last;
+    ANIM_PLAYER player;
+} ANIM_STATE;
+
+EFFECT_STATE_CHECK(ANIM_STATE);
 
-static void light_drop(uint8_t note, uint8_t velocity) {
-    done_check(note, velocity);
-    int white_note = midi_note_to_white(note);
-    int octave = midi_note_to_octave(note);
-    if ((white_note >= 0) && (octave >= START_OCTAVE)) {
-        octave -= START_OCTAVE;
-        int led_num = NUM_LEDS - 1 - (octave * 7) - white_note;
-        led_set(led_num, (RGB *)&note2color[white_note]);
+static void anim_init(RGB *frame, uint8_t arg) {
+    ANIM_STATE *st = EFFECT_STATE(ANIM_STATE);
+    if (arg >= anim_count) {
+        arg = 0;
     }
+    anim_open(&st->player, (const uint8_t *)pgm_read_ptr(&anim_table[arg]));
 }
 
-static void demo_color_piano2(void) {
-    printf_P(PSTR("\ncolor piano2"));
-    midi.note_on = light_drop;
-    midi.note_off = 0;
-
-    while (!demo_done) {
-        RGB next[NUM_LEDS];
-
-        for (int i = 0; i < NUM_LEDS; i ++) {
-            int left, right;
-            if (i == 0) {
-                left = NUM_LEDS - 1;
-                right = 1;
-            } else if (i == NUM_LEDS - 1) {
-                left = NUM_LEDS - 2;
-                right = 0;
-            } else {
-                left = i - 1;
-                right = i + 1;
-            }
-
-            RGB *l_rgb = led_get(left);
-            RGB *m_rgb = led_get(i);
-            RGB *r_rgb = led_get(right);
-
-            next[i].r = 332 * (l_rgb->r + m_rgb->r + r_rgb->r) / 1000;
-            next[i].g = 332 * (l_rgb->g + m_rgb->g + r_rgb->g) / 1000;
-            next[i].b = 332 * (l_rgb->b + m_rgb->b + r_rgb->b) / 1000;
-        }
+static int anim_render(RGB *frame, uint32_t t) {
+    ANIM_STATE *st = EFFECT_STATE(ANIM_STATE);
+    if (!effect_step(&st->last, t, st->player.period)) {
+        return 0;
+    }
+    return anim_frame(&st->player, frame, NUM_LEDS) >= 0;
+}
 
-        for (int i = 0; i < NUM_LEDS; i ++) {
-            led_set(i, &next[i]);
-        }
+//-----------------------------------------------------------------------------
+// demo - beat: flash the part of the keyboard for each beat of the bar,
+// locked to the midi clock
+
+typedef struct beat_state {
+    uint8_t lit;
+} BEAT_STATE;
+
+EFFECT_STATE_CHECK(BEAT_STATE);
 
-        timer_delay_msec_poll(40, midi_rx);
+static int beat_render(RGB *frame, uint32_t t) {
+    BEAT_STATE *st = EFFECT_STATE(BEAT_STATE);
+
+    if (!tempo.running || !tempo_locked()) {
+        if (st->lit) {
+            memset(frame, 0, NUM_LEDS * sizeof(RGB));
+            st->lit = 0;
+            return 1;
+        }
+        return 0;
     }
 
-    led_all_off();
-    demo_done = 0;
+    // fade out over the beat, accent the down beat
+    uint8_t level = 255 - tempo_phase();
+    RGB rgb;
+    if (tempo.beat == 0) {
+        rgb.r = level;
+        rgb.g = level >> 1;
+        rgb.b = 0;
+    } else {
+        rgb.r = 0;
+        rgb.g = level >> 2;
+        rgb.b = level;
+    }
+    uint8_t n = tempo.beats_per_bar ? tempo.beats_per_bar : 1;
+    uint8_t first = (tempo.beat * NUM_LEDS) / n;
+    uint8_t last = ((tempo.beat + 1) * NUM_LEDS) / n;
+    for (uint8_t i = 0; i < NUM_LEDS; i ++) {
+        if ((i >= first) && (i < last)) {
+            frame[i] = rgb;
+        } else {
+            frame[i].r = frame[i].g = frame[i].b = 0;
+        }
+    }
+    st->lit = 1;
+    return 1;
 }
 
 //-----------------------------------------------------------------------------
+// effect registry
+
+static const char name_keys[] PROGMEM = "keys";
+static const char name_all_white[] PROGMEM = "all white";
+static const char name_spectrum[] PROGMEM = "spectrum";
+static const char name_spectrum_scroll[] PROGMEM = "spectrum scroll";
+static const char name_chase1[] PROGMEM = "chase 1";
+static const char name_chase2[] PROGMEM = "chase 2";
+static const char name_chase3[] PROGMEM = "chase 3";
+static const char name_random[] PROGMEM = "random";
+static const char name_automata[] PROGMEM = "automata";
+static const char name_life[] PROGMEM = "life";
+static const char name_color_piano[] PROGMEM = "color piano";
+static const char name_color_piano2[] PROGMEM = "color piano 2";
+static const char name_ripple[] PROGMEM = "ripple";
+static const char name_anim[] PROGMEM = "animation";
+static const char name_host[] PROGMEM = "host";
+static const char name_host_keys[] PROGMEM = "host keys";
+static const char name_beat[] PROGMEM = "beat";
+
+const EFFECT effect_table[] PROGMEM = {
+    // name, arg, init, render, note
+    {name_keys, 0, 0, 0, 0},
+    {name_all_white, 0, all_white_init, 0, 0},
+    {name_spectrum, 0, spectrum_init, spectrum_render, 0},
+    {name_spectrum_scroll, 0, spectrum_scroll_init, spectrum_scroll_render, 0},
+    {name_chase1, 0, chase1_init, chase1_render, 0},
+    {name_chase2, 0, 0, chase2_render, 0},
+    {name_chase3, 0, 0, chase3_render, 0},
+    {name_random, 0, 0, random_render, 0},
+    {name_automata, 30, automata_init, automata_render, 0},
+    {name_automata, 90, automata_init, automata_render, 0},
+    {name_life, 0, life_init, life_render, 0},
+    {name_color_piano, 0, 0, 0, light_ctrl},
+    {name_color_piano2, 0, 0, color_piano2_render, light_drop},
+    {name_ripple, 0, 0, ripple_render, light_drop},
+    {name_anim, 0, anim_init, anim_render, 0},
+    {name_anim, 1, anim_init, anim_render, 0},
+    {name_host, 0, stream_effect_init, stream_effect_render, 0},
+    {name_host_keys, 0, stream_key_init, stream_key_render, 0},
+    {name_beat, 0, 0, beat_render, 0},
+};
+
+const uint8_t effect_count = sizeof(effect_table) / sizeof(EFFECT);
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,81 @@
+//-----------------------------------------------------------------------------
+/*
+
+1D Convolution/Diffusion Kernel
+
+Convolve a frame with a small symmetric or asymmetric kernel, in place.
+
+The weights sum to a power of 2 so normalisation is a shift, and the
+optional decay is a shift and a subtract - no divides and nothing wider
+than 16 bits (the weights are small, so the multiplies are 8x8).
+
+The frame is processed in a single pass with a rolling window holding the
+original values of the previous radius leds, which have already been
+overwritten. With wrap around the original values of the first radius leds
+are also kept for the end of the pass. The whole working set is a few
+bytes of stack instead of a copy of the frame.
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+
+#include "color.h"
+#include "diffuse.h"
+
+//-----------------------------------------------------------------------------
+
+static inline uint8_t diffuse_decay(uint16_t v, uint8_t decay) {
+    if (decay && v) {
+        uint8_t d = (v >> decay) | 1;
+        v -= d;
+    }
+    return v;
+}
+
+void diffuse(RGB *frame, uint8_t n, const DIFFUSE_KERNEL *k) {
+    uint8_t r = k->radius;
+    RGB hist[DIFFUSE_MAX_RADIUS];   // original values of frame[i - r .. i - 1]
+    RGB head[DIFFUSE_MAX_RADIUS];   // original values of frame[0 .. r - 1]
+
+    if ((r > DIFFUSE_MAX_RADIUS) || (n <= (2 * r))) {
+        return;
+    }
+
+    for (uint8_t j = 0; j < r; j ++) {
+        head[j] = frame[j];
+        hist[j] = k->wrap ? frame[n - r + j] : frame[0];
+    }
+
+    for (uint8_t i = 0; i < n; i ++) {
+        uint16_t sr = 0, sg = 0, sb = 0;
+        for (uint8_t j = 0; j <= 2 * r; j ++) {
+            const RGB *p;
+            uint8_t idx = i + j;    // frame index + r
+            if (j < r) {
+                p = &hist[j];
+            } else if (idx - r < n) {
+                p = &frame[idx - r];
+            } else {
+                p = k->wrap ? &head[idx - r - n] : &frame[n - 1];
+            }
+            uint8_t w = k->weight[j];
+            sr += p->r * w;
+            sg += p->g * w;
+            sb += p->b * w;
+        }
+        // slide the window
+        for (uint8_t j = 1; j < r; j ++) {
+            hist[j - 1] = hist[j];
+        }
+        if (r) {
+            hist[r - 1] = frame[i];
+        }
+        frame[i].r = diffuse_decay(sr >> k->shift, k->decay);
+        frame[i].g = diffuse_decay(sg >> k->shift, k->decay);
+        frame[i].b = diffuse_decay(sb >> k->shift, k->decay);
+    }
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,36 @@
+//-----------------------------------------------------------------------------
+/*
+
+1D Convolution/Diffusion Kernel
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef DIFFUSE_H
+#define DIFFUSE_H
+
+//-----------------------------------------------------------------------------
+
+#define DIFFUSE_MAX_RADIUS 2
+#define DIFFUSE_MAX_TAPS ((2 * DIFFUSE_MAX_RADIUS) + 1)
+
+typedef struct diffuse_kernel {
+
+    uint8_t radius;                     // taps = 2 * radius + 1
+    uint8_t weight[DIFFUSE_MAX_TAPS];   // must sum to 1 << shift
+    uint8_t shift;                      // normalisation, <= 8
+    uint8_t decay;                      // subtract (x >> decay) | 1, 0 = none
+    uint8_t wrap;                       // non-zero: the ends wrap around
+
+} DIFFUSE_KERNEL;
+
+//-----------------------------------------------------------------------------
+// API functions
+
+void diffuse(RGB *frame, uint8_t n, const DIFFUSE_KERNEL *k);
+
+//-----------------------------------------------------------------------------
+
+#endif // DIFFUSE_H
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,111 @@
+//-----------------------------------------------------------------------------
+/*
+
+LED Effect Engine
+
+Effects are registered in effect_table[] (see demo.cpp). Each one has an
+init() and a render() callback and an optional note() callback.
+
+The render loop (the frame task in app.cpp) calls effect_render() once
+per LED frame, just after the frame has been sent to the LEDs. Effects
+render into the background layer, which is then composed with the other
+layers into the led frame.
+
+Effects are selected at runtime by midi program change, or a note on for
+EFFECT_NOTE steps through them in turn.
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hal.h"
+#include "common.h"
+#include "color.h"
+#include "led.h"
+#include "layer.h"
+#include "bench.h"
+#include "effect.h"
+
+//-----------------------------------------------------------------------------
+
+// aligned for the host build, where the state structs aren't packed
+uint8_t effect_mem[EFFECT_MEM_SIZE] __attribute__((aligned(8)));
+
+static struct effect_control {
+    EFFECT fx;      // copy of the current registry entry
+    uint8_t idx;    // index of the current effect
+} effect;
+
+//-----------------------------------------------------------------------------
+// effect selection
+
+void effect_select(uint8_t idx) {
+    if (idx >= effect_count) {
+        idx = 0;
+    }
+    effect.idx = idx;
+    memcpy_P(&effect.fx, &effect_table[idx], sizeof(EFFECT));
+    printf_P(PSTR("\nfx %d "), idx);
+    fputs_P(effect.fx.name, stdout);
+
+    memset(effect_mem, 0, sizeof(effect_mem));
+    layer_clear(LAYER_BG);
+    if (effect.fx.init) {
+        effect.fx.init(layer_fb(LAYER_BG), effect.fx.arg);
+    }
+    layer_compose(0, NUM_LEDS);
+}
+
+void effect_next(void) {
+    effect_select(effect.idx + 1);
+}
+
+uint8_t effect_current(void) {
+    return effect.idx;
+}
+
+//-----------------------------------------------------------------------------
+// midi/key input
+
+void effect_note(uint8_t note, uint8_t velocity, int on_flag) {
+    if (note == EFFECT_NOTE) {
+        if (on_flag) {
+            effect_next();
+        }
+        return;
+    }
+    if (effect.fx.note) {
+        effect.fx.note(layer_fb(LAYER_BG), note, velocity, on_flag);
+        layer_compose(0, NUM_LEDS);
+    }
+}
+
+void effect_program(uint8_t program) {
+    effect_select(program);
+}
+
+//-----------------------------------------------------------------------------
+// render the background layer for time t, return non-zero if it changed
+
+int effect_render(uint32_t t) {
+    int changed = 0;
+    BENCH_BEGIN(BENCH_EFFECT(effect.idx));
+    if (effect.fx.render) {
+        changed = effect.fx.render(layer_fb(LAYER_BG), t);
+    }
+    BENCH_END(BENCH_EFFECT(effect.idx));
+    return changed;
+}
+
+//-----------------------------------------------------------------------------
+
+int effect_init(void) {
+    memset(&effect, 0, sizeof(effect));
+    effect_select(0);
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
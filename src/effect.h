@@ -0,0 +1,80 @@
+//-----------------------------------------------------------------------------
+/*
+
+LED Effect Engine
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef EFFECT_H
+#define EFFECT_H
+
+//-----------------------------------------------------------------------------
+
+// a note on for this midi note selects the next effect
+#define EFFECT_NOTE 24
+
+// private state memory, shared by all effects (only one runs at a time),
+// sized for the largest: the frame stream back buffer
+#define EFFECT_MEM_SIZE 169
+
+//-----------------------------------------------------------------------------
+
+typedef struct effect {
+
+    const char *name;   // in program memory
+    uint8_t arg;        // passed to init
+    // set up the effect, the frame is all off
+    void (*init)(RGB *frame, uint8_t arg);
+    // render the frame for time t (msec), return non-zero if it changed
+    int (*render)(RGB *frame, uint32_t t);
+    // optional note on/off (from the keys and midi input)
+    void (*note)(RGB *frame, uint8_t note, uint8_t velocity, int on_flag);
+
+} EFFECT;
+
+// the effect registry (in program memory)
+extern const EFFECT effect_table[] PROGMEM;
+extern const uint8_t effect_count;
+
+//-----------------------------------------------------------------------------
+// effect private state
+
+extern uint8_t effect_mem[EFFECT_MEM_SIZE];
+
+#define EFFECT_STATE(type) ((type *)(void *)effect_mem)
+
+// compile time check that a state type fits in the effect memory
+#define EFFECT_STATE_CHECK(type) \
+    typedef char type##_fits[(sizeof(type) <= EFFECT_MEM_SIZE) ? 1 : -1] __attribute__((unused))
+
+// Return non-zero (and advance *last) if period msecs have elapsed since
+// *last. Lets effects step at their own rate from a per frame render.
+static inline int effect_step(uint32_t *last, uint32_t t, uint16_t period) {
+    if ((uint32_t)(t - *last) < period) {
+        return 0;
+    }
+    *last += period;
+    if ((uint32_t)(t - *last) >= period) {
+        // more than a period behind, don't try to catch up
+        *last = t;
+    }
+    return 1;
+}
+
+//-----------------------------------------------------------------------------
+// API functions
+
+int effect_init(void);
+void effect_select(uint8_t idx);
+void effect_next(void);
+uint8_t effect_current(void);
+void effect_note(uint8_t note, uint8_t velocity, int on_flag);
+void effect_program(uint8_t program);
+int effect_render(uint32_t t);
+
+//-----------------------------------------------------------------------------
+
+#endif // EFFECT_H
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,114 @@
+//-----------------------------------------------------------------------------
+/*
+
+ADSR Envelope Generator
+
+A linear attack/decay/sustain/release envelope, stepped once per led frame.
+
+The peak level is set by the note velocity. The attack, decay and release
+times are converted once (by env_config) into full scale per frame rates
+in 8.8 fixed point, so stepping an envelope is a few 16 bit adds and
+compares and one 8x8 multiply for the sustain level.
+
+Each envelope is 3 bytes: the level and a control byte holding the stage
+and the peak level (5 bits).
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+
+#include "env.h"
+
+//-----------------------------------------------------------------------------
+
+#define ENV_STAGE(e)        ((e)->ctrl >> 5)
+#define ENV_PEAK(e)         ((e)->ctrl & 31)
+#define ENV_CTRL(stage, pk) (((stage) << 5) | (pk))
+
+// 5 bit peak to 8.8 level
+#define PEAK_LEVEL(pk)      ((uint16_t)(((pk) << 3) | ((pk) >> 2)) << 8)
+
+//-----------------------------------------------------------------------------
+
+// convert a time in msec to a full scale per frame rate
+static uint16_t env_rate(uint16_t ms) {
+    if (ms == 0) {
+        return 0xffff;
+    }
+    uint32_t rate = ((255UL << 8) * (ENV_FRAME_USEC / 8)) / (ms * 125UL);
+    if (rate == 0) {
+        return 1;
+    }
+    return (rate > 0xffff) ? 0xffff : rate;
+}
+
+void env_config(ENV_PARAMS *p, uint16_t attack_ms, uint16_t decay_ms, uint8_t sustain, uint16_t release_ms) {
+    p->attack = env_rate(attack_ms);
+    p->decay = env_rate(decay_ms);
+    p->release = env_rate(release_ms);
+    p->sustain = sustain;
+}
+
+//-----------------------------------------------------------------------------
+
+// start (or re-trigger) the envelope from its current level
+void env_on(ENVELOPE *e, uint8_t velocity) {
+    uint8_t pk = (velocity & 0x7f) >> 2;
+    if (pk == 0) {
+        pk = 1;
+    }
+    e->ctrl = ENV_CTRL(ENV_ATTACK, pk);
+}
+
+void env_off(ENVELOPE *e) {
+    if (ENV_STAGE(e) != ENV_IDLE) {
+        e->ctrl = ENV_CTRL(ENV_RELEASE, ENV_PEAK(e));
+    }
+}
+
+// advance the envelope one frame, return the new level (0..255)
+uint8_t env_step(ENVELOPE *e, const ENV_PARAMS *p) {
+    uint8_t pk = ENV_PEAK(e);
+    uint16_t peak = PEAK_LEVEL(pk);
+
+    switch (ENV_STAGE(e)) {
+        case ENV_ATTACK: {
+            if (e->level >= peak) {
+                // re-triggered above the new peak, just decay from here
+                e->ctrl = ENV_CTRL(ENV_DECAY, pk);
+            } else if (peak - e->level <= p->attack) {
+                e->level = peak;
+                e->ctrl = ENV_CTRL(ENV_DECAY, pk);
+            } else {
+                e->level += p->attack;
+            }
+            break;
+        }
+        case ENV_DECAY: {
+            uint16_t sustain = (uint16_t)((peak >> 8) * p->sustain) & 0xff00;
+            if ((e->level <= sustain) || (e->level - sustain <= p->decay)) {
+                e->level = sustain;
+                e->ctrl = ENV_CTRL(ENV_SUSTAIN, pk);
+            } else {
+                e->level -= p->decay;
+            }
+            break;
+        }
+        case ENV_RELEASE: {
+            if (e->level <= p->release) {
+                e->level = 0;
+                e->ctrl = ENV_CTRL(ENV_IDLE, pk);
+            } else {
+                e->level -= p->release;
+            }
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+    return e->level >> 8;
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,64 @@
+//-----------------------------------------------------------------------------
+/*
+
+ADSR Envelope Generator
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef ENV_H
+#define ENV_H
+
+//-----------------------------------------------------------------------------
+
+// envelopes are stepped once per led frame (2^8 / 15625 Hz = 16.4 ms)
+#define ENV_FRAME_USEC 16384
+
+// envelope stages
+#define ENV_IDLE    0
+#define ENV_ATTACK  1
+#define ENV_DECAY   2
+#define ENV_SUSTAIN 3
+#define ENV_RELEASE 4
+
+//-----------------------------------------------------------------------------
+
+// 3 bytes per envelope
+typedef struct envelope {
+
+    uint16_t level; // 8.8 fixed point, 0..255
+    uint8_t ctrl;   // stage (bits 7..5), peak level / 8 (bits 4..0)
+
+} ENVELOPE;
+
+// per frame rates, 8.8 fixed point, full scale
+typedef struct env_params {
+
+    uint16_t attack;
+    uint16_t decay;
+    uint16_t release;
+    uint8_t sustain;    // sustain level, fraction of peak (0..255)
+
+} ENV_PARAMS;
+
+//-----------------------------------------------------------------------------
+// API functions
+
+void env_config(ENV_PARAMS *p, uint16_t attack_ms, uint16_t decay_ms, uint8_t sustain, uint16_t release_ms);
+void env_on(ENVELOPE *e, uint8_t velocity);
+void env_off(ENVELOPE *e);
+uint8_t env_step(ENVELOPE *e, const ENV_PARAMS *p);
+
+static inline uint8_t env_stage(const ENVELOPE *e) {
+    return e->ctrl >> 5;
+}
+
+static inline uint8_t env_level(const ENVELOPE *e) {
+    return e->level >> 8;
+}
+
+//-----------------------------------------------------------------------------
+
+#endif // ENV_H
+
+//-----------------------------------------------------------------------------
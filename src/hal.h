@@ -0,0 +1,347 @@
+//-----------------------------------------------------------------------------
+/*
+
+Hardware Abstraction Layer
+
+The drivers reach the hardware through these calls rather than the AVR
+registers, so the rest of the code can also be built and run on a host
+(see hal_host.cpp and "make host").
+
+On the AVR they are inline and compile down to the same register accesses
+as before. On the host they run against a simulated device with a virtual
+clock: interrupts happen only when the code sleeps or spins waiting for
+one (hal_sleep, hal_spin), so code between those points takes no time,
+unless it says how long it would take on the device (hal_work).
+
+The ports are the ATmega328P ports B, C and D. The tick counter is timer 1
+at F_CPU / 8 (0.5 us per count), the frame timer is timer 0 overflowing at
+F_CPU / 1024 / 256 (16.4 ms).
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef HAL_H
+#define HAL_H
+
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+
+// ports
+#define HAL_PORTB 0
+#define HAL_PORTC 1
+#define HAL_PORTD 2
+
+//-----------------------------------------------------------------------------
+#if defined(__AVR__)
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <avr/sleep.h>
+#include <util/atomic.h>
+#include <util/delay.h>
+
+#include "timer.h"
+
+//-----------------------------------------------------------------------------
+// critical section (ATOMIC_BLOCK from util/atomic.h also works)
+
+static inline void hal_irq_disable(void) {
+    cli();
+}
+
+static inline void hal_irq_enable(void) {
+    sei();
+}
+
+//-----------------------------------------------------------------------------
+// port i/o
+
+static inline volatile uint8_t *hal_port_reg(uint8_t port) {
+    return (port == HAL_PORTB) ? &PORTB : (port == HAL_PORTC) ? &PORTC : &PORTD;
+}
+
+static inline volatile uint8_t *hal_ddr_reg(uint8_t port) {
+    return (port == HAL_PORTB) ? &DDRB : (port == HAL_PORTC) ? &DDRC : &DDRD;
+}
+
+static inline volatile uint8_t *hal_pin_reg(uint8_t port) {
+    return (port == HAL_PORTB) ? &PINB : (port == HAL_PORTC) ? &PINC : &PIND;
+}
+
+// set the mask bits of a port as outputs (1) or inputs (0)
+static inline void hal_port_dir(uint8_t port, uint8_t mask, uint8_t out) {
+    volatile uint8_t *ddr = hal_ddr_reg(port);
+    *ddr = (*ddr & ~mask) | (out & mask);
+}
+
+// write the mask bits of a port (or the pullups of inputs)
+static inline void hal_port_write(uint8_t port, uint8_t mask, uint8_t val) {
+    volatile uint8_t *reg = hal_port_reg(port);
+    *reg = (*reg & ~mask) | (val & mask);
+}
+
+// read the pins of a port
+static inline uint8_t hal_pin_read(uint8_t port) {
+    return *hal_pin_reg(port);
+}
+
+//-----------------------------------------------------------------------------
+// spi (master, fosc/4 = 4MHz)
+
+// bit assignments on port B
+#define HAL_SPI_SCK  5  // spi clock
+#define HAL_SPI_MISO 4  // master in, slave out
+#define HAL_SPI_MOSI 3  // master out, slave in
+#define HAL_SPI_SS   2  // slave select
+
+static inline void hal_spi_init(void) {
+    // ss, mosi, sck are outputs, ss is high
+    DDRB |= (1 << HAL_SPI_SCK) | (1 << HAL_SPI_MOSI) | (1 << HAL_SPI_SS);
+    PORTB |= (1 << HAL_SPI_SS);
+    // enable the spi in master mode - sets MISO to input
+    SPSR = 0;
+    SPCR = (1 << SPE) | (1 << MSTR);
+}
+
+// send a byte, wait for it to go
+static inline void hal_spi_tx(uint8_t c) {
+    SPDR = c;
+    while ((SPSR & (1 << SPIF)) == 0);
+}
+
+//-----------------------------------------------------------------------------
+// uart 0 (8 data bits, no parity, 1 stop bit)
+
+static inline void hal_uart_init(uint32_t baud) {
+    UBRR0L = (F_CPU / (8UL * baud)) - 1;
+    UBRR0H = 0;
+    // double speed
+    UCSR0A = _BV(U2X0);
+    // 8 data, no parity, 1 stop
+    UCSR0C = (3 << 1);
+    UCSR0B = _BV(TXEN0)|_BV(RXEN0)|_BV(RXCIE0);
+}
+
+// rx status (read before the data)
+#define HAL_UART_RX_READY   _BV(RXC0)
+#define HAL_UART_PARITY     _BV(UPE0)
+#define HAL_UART_FRAMING    _BV(FE0)
+#define HAL_UART_OVERRUN    _BV(DOR0)
+
+static inline uint8_t hal_uart_rx_status(void) {
+    return UCSR0A;
+}
+
+static inline uint8_t hal_uart_rx_byte(void) {
+    return UDR0;
+}
+
+static inline void hal_uart_tx_byte(uint8_t c) {
+    UDR0 = c;
+}
+
+// enable/disable the tx data register empty interrupt
+static inline void hal_uart_tx_irq(uint8_t on) {
+    if (on) {
+        UCSR0B |= (uint8_t)_BV(UDRIE0);
+    } else {
+        UCSR0B &= (uint8_t)~_BV(UDRIE0);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// tick counter (timer 1)
+
+static inline void hal_tick_init(void) {
+    TCCR1A = 0;
+    TCCR1B = DIVIDE_BY_8;
+    TCCR1C = 0;
+    OCR1A = 0;
+    OCR1B = 0;
+    ICR1 = 0;
+    TCNT1 = 0;
+    TIMSK1 = (1 << TOIE1);
+    TIFR1 = (1 << TOV1);
+}
+
+static inline uint16_t hal_tick_count(void) {
+    return TCNT1;
+}
+
+// non-zero if the counter has overflowed and the isr hasn't run
+static inline uint8_t hal_tick_ovf_pending(void) {
+    return (TIFR1 & (1 << TOV1)) != 0;
+}
+
+// one-shot interrupt when the counter reaches count
+static inline void hal_tick_alarm(uint16_t count) {
+    OCR1A = count;
+    TIFR1 = (1 << OCF1A);
+    TIMSK1 |= (1 << OCIE1A);
+}
+
+static inline void hal_tick_alarm_off(void) {
+    TIMSK1 &= ~(1 << OCIE1A);
+}
+
+//-----------------------------------------------------------------------------
+// frame timer (timer 0)
+
+static inline void hal_frame_timer_init(void) {
+    TCCR0A = 0;
+    TCCR0B = DIVIDE_BY_1024;
+    OCR0A = 0;
+    OCR0B = 0;
+    TIMSK0 = (1 << TOIE0);
+    TIFR0 = (1 << TOV0);
+}
+
+//-----------------------------------------------------------------------------
+// sleep and delays
+
+static inline void hal_sleep_init(void) {
+    set_sleep_mode(SLEEP_MODE_IDLE);
+}
+
+// Call with interrupts disabled. Enables them and sleeps until the next
+// interrupt. The instruction after sei is executed before any pending
+// interrupt, so a wakeup between the caller's checks and here can't be lost.
+static inline void hal_sleep(void) {
+    sleep_enable();
+    sei();
+    sleep_cpu();
+    sleep_disable();
+}
+
+// called in busy wait loops
+static inline void hal_spin(void) {
+}
+
+// main loop work that takes about usec on the device (for the host model)
+static inline void hal_work(uint8_t usec) {
+}
+
+// the led frame has been composed (for the host model)
+static inline void hal_frame_done(void) {
+}
+
+// delays (n must be a constant)
+#define hal_delay_usec(n) _delay_us(n)
+#define hal_delay_msec(n) _delay_ms(n)
+
+//-----------------------------------------------------------------------------
+#else // host
+
+#include <stdio.h>
+#include <string.h>
+
+//-----------------------------------------------------------------------------
+// avr-libc program memory and atomic block shims
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#define pgm_read_ptr(p) (*(void * const *)(p))
+#define memcpy_P memcpy
+#define strlen_P strlen
+#define printf_P printf
+#define fputs_P fputs
+
+#define ATOMIC_RESTORESTATE 0
+#define ATOMIC_BLOCK(type) \
+    for (uint8_t _irq = hal_atomic_start(), _done = 0; !_done; hal_atomic_end(_irq), _done = 1)
+
+//-----------------------------------------------------------------------------
+// simulated device
+
+typedef struct hal_host {
+
+    uint64_t usec;              // virtual time
+    uint8_t irq;                // interrupts enabled
+    uint8_t port[3];
+    uint8_t ddr[3];
+    // timers
+    uint8_t tick_on;
+    uint8_t frame_on;
+    uint8_t alarm_on;
+    uint64_t alarm_usec;
+    // uart
+    uint8_t uart_on;
+    uint8_t tx_irq;
+    uint64_t tx_free_usec;      // when the tx line is free
+    const uint8_t *rx_buf;      // pending input
+    uint32_t rx_len;
+    uint32_t rx_posn;
+    uint64_t rx_usec;           // when the next input byte arrives
+    uint8_t rx_data;
+    uint8_t rx_status;
+    // hooks for test harnesses
+    uint8_t (*pin_in)(uint8_t port);            // default: port latch
+    void (*spi_out)(uint8_t c);
+    void (*uart_out)(uint8_t c, uint64_t usec);
+    void (*frame_done)(void);
+
+} HAL_HOST;
+
+extern HAL_HOST hal_host;
+
+void hal_host_init(void);
+void hal_host_uart_input(const uint8_t *buf, uint32_t len);
+void hal_host_run(uint32_t usec);
+
+// critical section
+void hal_irq_disable(void);
+void hal_irq_enable(void);
+uint8_t hal_atomic_start(void);
+void hal_atomic_end(uint8_t irq);
+
+// port i/o
+void hal_port_dir(uint8_t port, uint8_t mask, uint8_t out);
+void hal_port_write(uint8_t port, uint8_t mask, uint8_t val);
+uint8_t hal_pin_read(uint8_t port);
+
+// spi
+void hal_spi_init(void);
+void hal_spi_tx(uint8_t c);
+
+// uart
+#define HAL_UART_RX_READY   (1 << 0)
+#define HAL_UART_PARITY     (1 << 1)
+#define HAL_UART_FRAMING    (1 << 2)
+#define HAL_UART_OVERRUN    (1 << 3)
+
+void hal_uart_init(uint32_t baud);
+uint8_t hal_uart_rx_status(void);
+uint8_t hal_uart_rx_byte(void);
+void hal_uart_tx_byte(uint8_t c);
+void hal_uart_tx_irq(uint8_t on);
+
+// tick counter
+void hal_tick_init(void);
+uint16_t hal_tick_count(void);
+uint8_t hal_tick_ovf_pending(void);
+void hal_tick_alarm(uint16_t count);
+void hal_tick_alarm_off(void);
+
+// frame timer
+void hal_frame_timer_init(void);
+
+// sleep and delays
+void hal_sleep_init(void);
+void hal_sleep(void);
+void hal_spin(void);
+void hal_work(uint8_t usec);
+void hal_frame_done(void);
+#define hal_delay_usec(n) hal_host_run(n)
+#define hal_delay_msec(n) hal_host_run((n) * 1000)
+
+#endif // host
+
+//-----------------------------------------------------------------------------
+
+#endif // HAL_H
+
+//-----------------------------------------------------------------------------
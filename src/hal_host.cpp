@@ -0,0 +1,332 @@
+//-----------------------------------------------------------------------------
+/*
+
+Hardware Abstraction Layer - Host Backend
+
+A simulated ATmega328P for running the firmware natively.
+
+Time is virtual. It only moves forward in hal_sleep(), hal_spin(),
+hal_work() and the delays, which run the interrupts that fall due in
+order, with ties going to the lower vector number as on the AVR.
+Everything else takes no time, so a run is repeatable. hal_work() marks
+main loop code that is long enough to be interrupted on the device (the
+led compose), so an isr can land in the middle of it as it would there.
+
+- timer 1 overflows every 32768 us (timer_ovf_isr), and the compare match
+  alarm fires when the 0.5 us count reaches the alarm value.
+- timer 0 overflows every 16384 us (led_isr).
+- uart input is queued with hal_host_uart_input() and arrives a byte every
+  320 us (31250 baud, 10 bits per byte). Output bytes take as long to go.
+
+Test harnesses can hook the pin reads (key matrix), the spi output (led
+modules), the uart output and the end of each led compose through the
+hal_host hooks.
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hal.h"
+#include "timer.h"
+#include "uart.h"
+#include "color.h"
+#include "led.h"
+
+//-----------------------------------------------------------------------------
+
+#define HOST_OVF_USEC   32768   // timer 1 overflow
+#define HOST_FRAME_USEC 16384   // timer 0 overflow
+#define HOST_BYTE_USEC  320     // uart byte time
+
+#define HOST_NEVER      (~(uint64_t)0)
+
+//-----------------------------------------------------------------------------
+
+HAL_HOST hal_host;
+
+static uint64_t tick_base;      // time the tick counter was zero
+static uint64_t tick_ovf;       // next timer 1 overflow
+static uint64_t frame_ovf;      // next timer 0 overflow
+
+//-----------------------------------------------------------------------------
+// interrupt dispatch
+
+enum {
+    HOST_IRQ_NONE,
+    HOST_IRQ_ALARM,     // TIMER1_COMPA
+    HOST_IRQ_TICK,      // TIMER1_OVF
+    HOST_IRQ_FRAME,     // TIMER0_OVF
+    HOST_IRQ_RX,        // USART_RX
+    HOST_IRQ_TX,        // USART_UDRE
+};
+
+// find the next interrupt, return its time
+static uint64_t host_next(int *irq) {
+    uint64_t t = HOST_NEVER;
+    *irq = HOST_IRQ_NONE;
+
+    // in vector order, so only an earlier time wins
+    if (hal_host.alarm_on && (hal_host.alarm_usec < t)) {
+        t = hal_host.alarm_usec;
+        *irq = HOST_IRQ_ALARM;
+    }
+    if (hal_host.tick_on && (tick_ovf < t)) {
+        t = tick_ovf;
+        *irq = HOST_IRQ_TICK;
+    }
+    if (hal_host.frame_on && (frame_ovf < t)) {
+        t = frame_ovf;
+        *irq = HOST_IRQ_FRAME;
+    }
+    if (hal_host.uart_on && (hal_host.rx_posn < hal_host.rx_len) && (hal_host.rx_usec < t)) {
+        t = hal_host.rx_usec;
+        *irq = HOST_IRQ_RX;
+    }
+    if (hal_host.uart_on && hal_host.tx_irq) {
+        uint64_t tx = (hal_host.tx_free_usec > hal_host.usec) ? hal_host.tx_free_usec : hal_host.usec;
+        if (tx < t) {
+            t = tx;
+            *irq = HOST_IRQ_TX;
+        }
+    }
+    return t;
+}
+
+// run the next interrupt if it is due by limit, return non-zero if one ran
+static int host_event(uint64_t limit) {
+    int irq;
+    uint64_t t = host_next(&irq);
+    if ((irq == HOST_IRQ_NONE) || (t > limit)) {
+        return 0;
+    }
+    if (t > hal_host.usec) {
+        hal_host.usec = t;
+    }
+    uint8_t irq_save = hal_host.irq;
+    hal_host.irq = 0;
+    switch (irq) {
+        case HOST_IRQ_ALARM: {
+            hal_host.alarm_on = 0;
+            timer_alarm_isr();
+            break;
+        }
+        case HOST_IRQ_TICK: {
+            tick_ovf += HOST_OVF_USEC;
+            timer_ovf_isr();
+            break;
+        }
+        case HOST_IRQ_FRAME: {
+            frame_ovf += HOST_FRAME_USEC;
+            led_isr();
+            break;
+        }
+        case HOST_IRQ_RX: {
+            if (hal_host.rx_status & HAL_UART_RX_READY) {
+                hal_host.rx_status |= HAL_UART_OVERRUN;
+            }
+            hal_host.rx_data = hal_host.rx_buf[hal_host.rx_posn ++];
+            hal_host.rx_status |= HAL_UART_RX_READY;
+            hal_host.rx_usec += HOST_BYTE_USEC;
+            uart_rx_isr();
+            break;
+        }
+        case HOST_IRQ_TX: {
+            uart_tx_isr();
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+    hal_host.irq = irq_save;
+    return 1;
+}
+
+//-----------------------------------------------------------------------------
+// simulation control
+
+void hal_host_init(void) {
+    memset(&hal_host, 0, sizeof(hal_host));
+    tick_base = 0;
+    tick_ovf = HOST_OVF_USEC;
+    frame_ovf = HOST_FRAME_USEC;
+}
+
+// queue bytes to arrive on the uart (replacing any not yet received)
+void hal_host_uart_input(const uint8_t *buf, uint32_t len) {
+    if (hal_host.rx_posn >= hal_host.rx_len) {
+        hal_host.rx_usec = hal_host.usec + HOST_BYTE_USEC;
+    }
+    hal_host.rx_buf = buf;
+    hal_host.rx_len = len;
+    hal_host.rx_posn = 0;
+}
+
+// advance the time by usec, running the interrupts as they fall due
+void hal_host_run(uint32_t usec) {
+    uint64_t limit = hal_host.usec + usec;
+    while (host_event(limit));
+    hal_host.usec = limit;
+}
+
+//-----------------------------------------------------------------------------
+// critical section
+
+void hal_irq_disable(void) {
+    hal_host.irq = 0;
+}
+
+void hal_irq_enable(void) {
+    hal_host.irq = 1;
+}
+
+uint8_t hal_atomic_start(void) {
+    uint8_t irq = hal_host.irq;
+    hal_host.irq = 0;
+    return irq;
+}
+
+void hal_atomic_end(uint8_t irq) {
+    hal_host.irq = irq;
+}
+
+//-----------------------------------------------------------------------------
+// port i/o
+
+void hal_port_dir(uint8_t port, uint8_t mask, uint8_t out) {
+    hal_host.ddr[port] = (hal_host.ddr[port] & ~mask) | (out & mask);
+}
+
+void hal_port_write(uint8_t port, uint8_t mask, uint8_t val) {
+    hal_host.port[port] = (hal_host.port[port] & ~mask) | (val & mask);
+}
+
+uint8_t hal_pin_read(uint8_t port) {
+    if (hal_host.pin_in) {
+        return hal_host.pin_in(port);
+    }
+    // outputs read back, inputs read their pullups
+    return hal_host.port[port];
+}
+
+//-----------------------------------------------------------------------------
+// spi
+
+void hal_spi_init(void) {
+}
+
+void hal_spi_tx(uint8_t c) {
+    if (hal_host.spi_out) {
+        hal_host.spi_out(c);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// uart
+
+void hal_uart_init(uint32_t baud) {
+    hal_host.uart_on = 1;
+    hal_host.rx_status = 0;
+    hal_host.tx_irq = 0;
+}
+
+uint8_t hal_uart_rx_status(void) {
+    return hal_host.rx_status;
+}
+
+uint8_t hal_uart_rx_byte(void) {
+    hal_host.rx_status = 0;
+    return hal_host.rx_data;
+}
+
+void hal_uart_tx_byte(uint8_t c) {
+    uint64_t start = (hal_host.tx_free_usec > hal_host.usec) ? hal_host.tx_free_usec : hal_host.usec;
+    hal_host.tx_free_usec = start + HOST_BYTE_USEC;
+    if (hal_host.uart_out) {
+        hal_host.uart_out(c, start);
+    }
+}
+
+void hal_uart_tx_irq(uint8_t on) {
+    hal_host.tx_irq = on;
+}
+
+//-----------------------------------------------------------------------------
+// tick counter
+
+void hal_tick_init(void) {
+    hal_host.tick_on = 1;
+    hal_host.alarm_on = 0;
+    tick_base = hal_host.usec;
+    tick_ovf = tick_base + HOST_OVF_USEC;
+}
+
+uint16_t hal_tick_count(void) {
+    return (uint16_t)((hal_host.usec - tick_base) << 1);
+}
+
+uint8_t hal_tick_ovf_pending(void) {
+    // overflows are run exactly when they happen
+    return 0;
+}
+
+void hal_tick_alarm(uint16_t count) {
+    uint16_t dt = count - hal_tick_count();
+    uint32_t ticks = dt ? dt : 0x10000;
+    hal_host.alarm_usec = hal_host.usec + ((ticks + 1) >> 1);
+    hal_host.alarm_on = 1;
+}
+
+void hal_tick_alarm_off(void) {
+    hal_host.alarm_on = 0;
+}
+
+//-----------------------------------------------------------------------------
+// frame timer
+
+void hal_frame_timer_init(void) {
+    hal_host.frame_on = 1;
+    frame_ovf = hal_host.usec + HOST_FRAME_USEC;
+}
+
+//-----------------------------------------------------------------------------
+// sleep
+
+void hal_sleep_init(void) {
+}
+
+// sleep until the next interrupt
+void hal_sleep(void) {
+    hal_host.irq = 1;
+    if (!host_event(HOST_NEVER)) {
+        // nothing can wake us, let time pass
+        hal_host.usec += 1000;
+    }
+}
+
+// waiting for an interrupt to change something
+void hal_spin(void) {
+    if (!host_event(HOST_NEVER)) {
+        hal_host.usec += 1;
+    }
+}
+
+// usec of work, the interrupts that fall due run if they are enabled
+void hal_work(uint8_t usec) {
+    uint64_t limit = hal_host.usec + usec;
+    if (hal_host.irq) {
+        while (host_event(limit));
+    }
+    hal_host.usec = limit;
+}
+
+void hal_frame_done(void) {
+    if (hal_host.frame_done) {
+        hal_host.frame_done();
+    }
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,247 @@
+//-----------------------------------------------------------------------------
+/*
+
+MIDI Lights - Host Build
+
+Runs the application against the simulated device in hal_host.cpp.
+
+usage: midilights_host [-t msec] [-e effect] [-c capture_file] [-o midi_out] [midi_file]
+
+-t msec     run time in virtual msecs (default 5000)
+-e effect   select an effect (index in the effect registry)
+-c file     capture the led frames (see below and tools/ledview.py)
+-o file     write the midi output bytes to a file (e.g. for tools/tracedump.py)
+midi_file   raw midi bytes to feed to the uart at 31250 baud
+
+The MIDI output is printed as it is sent, with the scheduler and idle
+statistics once a second.
+
+The capture file has an 8 byte header: "LEDC", a version (2), the number
+of leds and 2 zero bytes. Then a record for each burst led_isr() pushed
+on the spi chain and for each compose of the led frame, in the order they
+happened:
+
+    uint32_t usec       virtual time (little endian)
+    uint8_t frame       led_frame_count()
+    uint8_t n           burst: modules pushed, from the start of the chain
+                        compose: 0x80 | number of leds
+    uint8_t bgr[n][3]   as sent (blue, red, green)
+
+Modules past n keep the data from earlier frames. A compose record is the
+led frame as it stands when the compose ends (led_update()).
+
+The compose takes virtual time (hal_work() in layer.cpp), so led_isr()
+can run in the middle of one as it can on the device. A burst that
+matches neither the compose before it nor the one it interrupted is a
+torn frame, tools/ledview.py counts them.
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "hal.h"
+#include "common.h"
+#include "uart.h"
+#include "timer.h"
+#include "color.h"
+#include "led.h"
+#include "midi.h"
+#include "key.h"
+#include "sched.h"
+#include "idle.h"
+#include "effect.h"
+#include "boot.h"
+#include "app.h"
+
+//-----------------------------------------------------------------------------
+
+#define HOST_RUN_MSEC 5000
+#define HOST_MIDI_MAX 65536
+
+static uint8_t midi_in[HOST_MIDI_MAX];
+static uint32_t spi_bytes;
+
+// led frame capture
+#define CAPTURE_VERSION 2
+#define CAPTURE_COMPOSE 0x80
+
+static FILE *capture;
+static FILE *midi_out;
+static uint64_t capture_usec;
+static uint8_t capture_frame;
+static uint8_t capture_buf[NUM_LEDS * 3];
+static int capture_len = -1;    // bytes in the current burst, -1 = none
+
+//-----------------------------------------------------------------------------
+// device hooks
+
+static void host_uart_out(uint8_t c, uint64_t usec) {
+    printf("\ntx %10.3f ms: %02x", (double)usec / 1000.0, c);
+    if (midi_out) {
+        fputc(c, midi_out);
+    }
+}
+
+static void capture_flush(void) {
+    if (capture_len < 0) {
+        return;
+    }
+    uint32_t usec = capture_usec;
+    uint8_t hdr[6] = {
+        (uint8_t)usec, (uint8_t)(usec >> 8), (uint8_t)(usec >> 16), (uint8_t)(usec >> 24),
+        capture_frame, (uint8_t)(capture_len / 3),
+    };
+    fwrite(hdr, 1, sizeof(hdr), capture);
+    fwrite(capture_buf, 1, (capture_len / 3) * 3, capture);
+    capture_len = -1;
+}
+
+static void host_spi_out(uint8_t c) {
+    spi_bytes += 1;
+    if (!capture) {
+        return;
+    }
+    // time doesn't pass in an isr, so a burst has a single timestamp
+    if ((capture_len >= 0) && (hal_host.usec != capture_usec)) {
+        capture_flush();
+    }
+    if (capture_len < 0) {
+        capture_usec = hal_host.usec;
+        capture_frame = led_frame_count();
+        capture_len = 0;
+    }
+    if (capture_len < (int)sizeof(capture_buf)) {
+        capture_buf[capture_len ++] = c;
+    }
+}
+
+// the led frame has been composed, record it to compare the bursts with
+static void host_frame_done(void) {
+    if (!capture) {
+        return;
+    }
+    capture_flush();
+    uint32_t usec = hal_host.usec;
+    uint8_t hdr[6] = {
+        (uint8_t)usec, (uint8_t)(usec >> 8), (uint8_t)(usec >> 16), (uint8_t)(usec >> 24),
+        led_frame_count(), CAPTURE_COMPOSE | NUM_LEDS,
+    };
+    fwrite(hdr, 1, sizeof(hdr), capture);
+    const RGB *led = led_frame();
+    for (int i = 0; i < NUM_LEDS; i ++) {
+        uint8_t bgr[3] = {led[i].b, led[i].r, led[i].g};
+        fwrite(bgr, 1, sizeof(bgr), capture);
+    }
+}
+
+static int capture_open(const char *name) {
+    capture = fopen(name, "wb");
+    if (!capture) {
+        perror(name);
+        return -1;
+    }
+    uint8_t hdr[8] = {'L', 'E', 'D', 'C', CAPTURE_VERSION, NUM_LEDS, 0, 0};
+    fwrite(hdr, 1, sizeof(hdr), capture);
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+
+static void stats_task(void) {
+    sched_stats();
+    idle_stats();
+    printf("\n%lu ms: loops %u/s, busy %u.%u%%, sleeps %u/s, led frames %u, spi %lu bytes",
+        (unsigned long)timer_get_msec(), sched.loop_rate, idle.duty / 10, idle.duty % 10,
+        idle.sleep_rate, led_frame_count(), (unsigned long)spi_bytes);
+}
+
+static int load_midi(const char *name) {
+    FILE *f = fopen(name, "rb");
+    if (!f) {
+        perror(name);
+        return -1;
+    }
+    size_t n = fread(midi_in, 1, sizeof(midi_in), f);
+    fclose(f);
+    hal_host_uart_input(midi_in, n);
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    uint32_t run_msec = HOST_RUN_MSEC;
+    int effect = -1;
+    int c;
+
+    while ((c = getopt(argc, argv, "t:e:c:o:")) != -1) {
+        switch (c) {
+            case 't': run_msec = strtoul(optarg, 0, 0); break;
+            case 'e': effect = atoi(optarg); break;
+            case 'c': {
+                if (capture_open(optarg) != 0) {
+                    return 1;
+                }
+                break;
+            }
+            case 'o': {
+                midi_out = fopen(optarg, "wb");
+                if (!midi_out) {
+                    perror(optarg);
+                    return 1;
+                }
+                break;
+            }
+            default: {
+                fprintf(stderr, "usage: %s [-t msec] [-e effect] [-c capture_file] [-o midi_out] [midi_file]\n", argv[0]);
+                return 1;
+            }
+        }
+    }
+
+    hal_host_init();
+    hal_host.uart_out = host_uart_out;
+    hal_host.spi_out = host_spi_out;
+    hal_host.frame_done = host_frame_done;
+    hal_irq_enable();
+
+    // the firmware's boot order, but any failure stops the run
+    if ((app_boot() != 0) || (boot.fails != 0)) {
+        return 1;
+    }
+    boot_ready();
+
+    if ((optind < argc) && (load_midi(argv[optind]) != 0)) {
+        return 1;
+    }
+    if (effect >= 0) {
+        effect_select(effect);
+    }
+
+    if (sched_add(stats_task, 1000, 1000, SCHED_PRIO_LOW) < 0) {
+        fprintf(stderr, "no task slot for the stats\n");
+        return 1;
+    }
+
+    while (!timer_after(timer_get_msec(), run_msec)) {
+        if (!sched_run()) {
+            app_idle();
+        }
+    }
+    if (capture) {
+        capture_flush();
+        fclose(capture);
+    }
+    if (midi_out) {
+        fclose(midi_out);
+    }
+    printf("\n");
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,77 @@
+//-----------------------------------------------------------------------------
+/*
+
+Idle Sleep
+
+When the scheduler has nothing to run, put the cpu into SLEEP_MODE_IDLE.
+
+The timers, UART and SPI keep running in idle mode so any of the existing
+interrupts wake the cpu: UART rx (midi input), timer 0 (led update) and
+timer 1. A timer 1 compare match alarm is set for the next timed task so a
+key scan is never later than it would be when spinning.
+
+The time spent asleep is measured with the microsecond timer to give the
+duty cycle - the fraction of time the cpu was doing something. The isr
+that wakes the cpu runs before we can read the time, so its cost is
+counted as idle.
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+
+#include "hal.h"
+#include "timer.h"
+#include "sched.h"
+#include "idle.h"
+
+//-----------------------------------------------------------------------------
+
+IDLE_CTRL idle;
+
+//-----------------------------------------------------------------------------
+// sleep until the next interrupt
+
+void idle_sleep(void) {
+    uint32_t due;
+
+    hal_irq_disable();
+    // an isr may have released a task since the scheduler last looked
+    if (sched_next_due(&due)) {
+        hal_irq_enable();
+        return;
+    }
+    timer_set_alarm(due);
+    uint32_t t0 = timer_get_usec();
+    // enables interrupts and sleeps, a wakeup from here on isn't lost
+    hal_sleep();
+    idle.idle_usec += timer_get_usec() - t0;
+    idle.sleeps ++;
+}
+
+//-----------------------------------------------------------------------------
+// latch the per second counters - run this as a 1000 ms periodic task
+
+void idle_stats(void) {
+    uint32_t now = timer_get_usec();
+    uint32_t total = now - idle.last_usec;
+    uint32_t busy = (idle.idle_usec < total) ? (total - idle.idle_usec) : 0;
+    // scale both down to keep the multiply in 32 bits
+    idle.duty = (total >> 10) ? (((busy >> 10) * 1000) / (total >> 10)) : 0;
+    idle.sleep_rate = idle.sleeps;
+    idle.sleeps = 0;
+    idle.idle_usec = 0;
+    idle.last_usec = now;
+}
+
+//-----------------------------------------------------------------------------
+
+int idle_init(void) {
+    memset(&idle, 0, sizeof(idle));
+    idle.last_usec = timer_get_usec();
+    hal_sleep_init();
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
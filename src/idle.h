@@ -0,0 +1,37 @@
+//-----------------------------------------------------------------------------
+/*
+
+Idle Sleep
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef IDLE_H
+#define IDLE_H
+
+//-----------------------------------------------------------------------------
+
+typedef struct idle_control {
+
+    uint32_t idle_usec;     // time asleep in the current second
+    uint32_t last_usec;     // time of the last idle_stats() call
+    uint16_t sleeps;        // sleeps in the current second
+    uint16_t sleep_rate;    // sleeps in the last second
+    uint16_t duty;          // busy time in the last second (0.1% units)
+
+} IDLE_CTRL;
+
+extern IDLE_CTRL idle;
+
+//-----------------------------------------------------------------------------
+// API functions
+
+int idle_init(void);
+void idle_sleep(void);
+void idle_stats(void);
+
+//-----------------------------------------------------------------------------
+
+#endif // IDLE_H
+
+//-----------------------------------------------------------------------------
@@ -9,28 +9,55 @@ ISR Entry Points
 #include <stdio.h>
 #include <avr/interrupt.h>
 
+#include "hal.h"
 #include "uart.h"
 #include "timer.h"
 #include "color.h"
 #include "led.h"
+#include "bench.h"
+#include "isrprof.h"
 
 //-----------------------------------------------------------------------------
 // ISR Entry Points
 
 ISR(USART_RX_vect) {
+    BENCH_BEGIN(BENCH_UART_RX_ISR);
+    ISRPROF_BEGIN();
     uart_rx_isr();
+    ISRPROF_END(ISRPROF_UART_RX);
+    BENCH_END(BENCH_UART_RX_ISR);
 }
 
 ISR(USART_UDRE_vect) {
+    BENCH_BEGIN(BENCH_UART_TX_ISR);
+    ISRPROF_BEGIN();
     uart_tx_isr();
+    ISRPROF_END(ISRPROF_UART_TX);
+    BENCH_END(BENCH_UART_TX_ISR);
 }
 
 ISR(TIMER0_OVF_vect) {
+    BENCH_BEGIN(BENCH_LED_ISR);
+    ISRPROF_BEGIN();
     led_isr();
+    ISRPROF_END(ISRPROF_LED);
+    BENCH_END(BENCH_LED_ISR);
 }
 
 ISR(TIMER1_OVF_vect) {
+    BENCH_BEGIN(BENCH_TIMER_OVF_ISR);
+    ISRPROF_BEGIN();
     timer_ovf_isr();
+    ISRPROF_END(ISRPROF_TIMER_OVF);
+    BENCH_END(BENCH_TIMER_OVF_ISR);
+}
+
+ISR(TIMER1_COMPA_vect) {
+    BENCH_BEGIN(BENCH_TIMER_ALARM_ISR);
+    ISRPROF_BEGIN();
+    timer_alarm_isr();
+    ISRPROF_END(ISRPROF_TIMER_ALARM);
+    BENCH_END(BENCH_TIMER_ALARM_ISR);
 }
 
 //-----------------------------------------------------------------------------
@@ -0,0 +1,91 @@
+//-----------------------------------------------------------------------------
+/*
+
+ISR Profiler
+
+The isrs run with interrupts disabled, so a long one (led_isr() pushing
+the whole chain) delays all the others. With ISR_PROFILE defined each
+entry point in isr.cpp reads timer 1 before and after its handler and
+keeps the call count and the min, max and total duration, in 0.5 usec
+ticks. The isr prologue and epilogue (register saves) aren't included,
+and the profiling itself makes them a little longer.
+
+The uart rx flag can't be timestamped, but it can be seen: any isr that
+ends with the rx flag set had a byte arrive while it ran and held off the
+rx isr by up to its whole duration. The longest of those is rx_wait_max.
+The receiver holds one byte while the next shifts in, so the uart can't
+overrun while that (plus the critical sections in the main loop) stays
+under a byte time: 320 usecs, 640 ticks at 31250 baud.
+
+The stats are read with isrprof_get() and isrprof_rx_wait_max() at any
+time, isrprof_reset() starts over. This file is only built with
+ISR_PROFILE, the stats take 64 bytes of ram.
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+
+#include "hal.h"
+#include "isrprof.h"
+
+//-----------------------------------------------------------------------------
+
+ISRPROF_CTRL isrprof;
+
+//-----------------------------------------------------------------------------
+
+// record an isr that started at t0, called with interrupts disabled
+void isrprof_end(uint8_t id, uint16_t t0) {
+    uint16_t t = hal_tick_count() - t0;
+    ISRPROF_STATS *s = &isrprof.isr[id];
+    s->count ++;
+    s->total += t;
+    if (t < s->min) {
+        s->min = t;
+    }
+    if (t > s->max) {
+        s->max = t;
+    }
+    if ((id != ISRPROF_UART_RX) && (hal_uart_rx_status() & HAL_UART_RX_READY)) {
+        // a byte arrived during this isr
+        if (t > isrprof.rx_wait_max) {
+            isrprof.rx_wait_max = t;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void isrprof_get(uint8_t id, ISRPROF_STATS *s) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        *s = isrprof.isr[id];
+    }
+}
+
+uint16_t isrprof_rx_wait_max(void) {
+    uint16_t t;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        t = isrprof.rx_wait_max;
+    }
+    return t;
+}
+
+void isrprof_reset(void) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        memset(&isrprof, 0, sizeof(isrprof));
+        for (uint8_t i = 0; i < ISRPROF_NUM; i ++) {
+            isrprof.isr[i].min = 0xffff;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+int isrprof_init(void) {
+    isrprof_reset();
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
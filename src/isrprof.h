@@ -0,0 +1,68 @@
+//-----------------------------------------------------------------------------
+/*
+
+ISR Profiler
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef ISRPROF_H
+#define ISRPROF_H
+
+//-----------------------------------------------------------------------------
+
+// isrs
+#define ISRPROF_UART_RX     0
+#define ISRPROF_UART_TX     1
+#define ISRPROF_LED         2
+#define ISRPROF_TIMER_OVF   3
+#define ISRPROF_TIMER_ALARM 4
+#define ISRPROF_NUM         5
+
+//-----------------------------------------------------------------------------
+
+// times are in timer 1 ticks (0.5 usec)
+typedef struct isrprof_stats {
+
+    uint32_t count;
+    uint32_t total;
+    uint16_t min;
+    uint16_t max;
+
+} ISRPROF_STATS;
+
+typedef struct isrprof_control {
+
+    ISRPROF_STATS isr[ISRPROF_NUM];
+    uint16_t rx_wait_max;   // longest isr that ended with an rx byte waiting
+
+} ISRPROF_CTRL;
+
+extern ISRPROF_CTRL isrprof;
+
+//-----------------------------------------------------------------------------
+// With ISR_PROFILE defined ("make ISR_PROFILE=1") the isr entry points
+// time their handlers, otherwise these compile to nothing.
+
+#if defined(ISR_PROFILE)
+#define ISRPROF_BEGIN() uint16_t isrprof_t0 = hal_tick_count()
+#define ISRPROF_END(id) isrprof_end(id, isrprof_t0)
+#else
+#define ISRPROF_BEGIN()
+#define ISRPROF_END(id)
+#endif
+
+//-----------------------------------------------------------------------------
+// API functions
+
+int isrprof_init(void);
+void isrprof_end(uint8_t id, uint16_t t0);
+void isrprof_get(uint8_t id, ISRPROF_STATS *s);
+uint16_t isrprof_rx_wait_max(void);
+void isrprof_reset(void);
+
+//-----------------------------------------------------------------------------
+
+#endif // ISRPROF_H
+
+//-----------------------------------------------------------------------------
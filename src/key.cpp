@@ -19,10 +19,12 @@ a low on the input when it is scanned.
 */
 //-----------------------------------------------------------------------------
 
-#include <avr/io.h>
 #include <stdint.h>
 #include <string.h>
 
+#include "hal.h"
+#include "bench.h"
+#include "trace.h"
 #include "key.h"
 
 //-----------------------------------------------------------------------------
@@ -34,20 +36,20 @@ KEY_CTRL keys;
 
 // read all column lines
 static uint8_t key_rd(void) {
-    return ~PINC & 15;
+    return ~hal_pin_read(HAL_PORTC) & 15;
 }
 
 // select a row line
 static void key_wr(uint8_t row) {
-    PORTB = (PORTB & ~7) | row;
+    hal_port_write(HAL_PORTB, 7, row);
 }
 
 static void key_io_init(void) {
     // rows: portb 0..2 set as outputs
-    DDRB |= 7;
+    hal_port_dir(HAL_PORTB, 7, 7);
     // columns: portc 0..3 set as inputs with pullup resistors
-    DDRC &= ~15;
-    PORTC |= 15;
+    hal_port_dir(HAL_PORTC, 15, 0);
+    hal_port_write(HAL_PORTC, 15, 15);
 }
 
 //-----------------------------------------------------------------------------
@@ -66,10 +68,8 @@ static void key_io_init(void) {
 #define KEY_COUNT(x)            (keys.state[x] & (31 << 0))
 #define KEY_STATE(x)            (keys.state[x] & (7 << 5))
 
-#define DEBOUNCE_COUNT_DOWN     2
-#define DEBOUNCE_COUNT_UP       4
-
 void key_scan(void) {
+    BENCH_BEGIN(BENCH_KEY_SCAN);
 
     // read the column lines
     int col = key_rd();
@@ -85,8 +85,9 @@ void key_scan(void) {
                     keys.state[key] = KEY_STATE_UP;
                 } else {
                     int n = KEY_COUNT(key);
-                    if (n >= DEBOUNCE_COUNT_DOWN) {
+                    if (n >= keys.debounce_down) {
                         keys.state[key] = KEY_STATE_DOWN;
+                        TRACE(TRACE_KEY_DOWN, key, 0);
                         if (keys.key_down) {
                             keys.key_down(key);
                         }
@@ -109,8 +110,9 @@ void key_scan(void) {
                     keys.state[key] = KEY_STATE_DOWN;
                 } else {
                     int n = KEY_COUNT(key);
-                    if (n >= DEBOUNCE_COUNT_UP) {
+                    if (n >= keys.debounce_up) {
                         keys.state[key] = KEY_STATE_UP;
+                        TRACE(TRACE_KEY_UP, key, 0);
                         if (keys.key_up) {
                             keys.key_up(key);
                         }
@@ -142,6 +144,7 @@ void key_scan(void) {
         keys.row = 0;
     }
     key_wr(keys.row);
+    BENCH_END(BENCH_KEY_SCAN);
 }
 
 //-----------------------------------------------------------------------------
@@ -149,6 +152,8 @@ void key_scan(void) {
 int key_init(void) {
     key_io_init();
     memset(&keys, 0, sizeof(keys));
+    keys.debounce_down = KEY_DEBOUNCE_DOWN;
+    keys.debounce_up = KEY_DEBOUNCE_UP;
     key_wr(keys.row);
     return 0;
 }
@@ -16,12 +16,20 @@ Key Scanning
 #define KEY_COLS 4
 #define NUM_KEYS (KEY_ROWS * KEY_COLS)
 
+// default debounce counts (0..31)
+// a change is reported after count + 2 successive samples of the new state,
+// with each key sampled every KEY_ROWS scans
+#define KEY_DEBOUNCE_DOWN 2
+#define KEY_DEBOUNCE_UP 4
+
 //-----------------------------------------------------------------------------
 
 typedef struct key_control {
 
     uint8_t row;
     uint8_t state[NUM_KEYS];
+    uint8_t debounce_down;      // debounce counts, see KEY_DEBOUNCE_x
+    uint8_t debounce_up;
     void (*key_down)(uint8_t key);
     void (*key_up)(uint8_t key);
 
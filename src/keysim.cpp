@@ -0,0 +1,482 @@
+//-----------------------------------------------------------------------------
+/*
+
+Key Bounce Simulator
+
+Runs key_scan() on the host against generated switch waveforms and
+reports how each pair of debounce counts handles them.
+
+The waveforms are read through the hal pin hook, so key_scan() sees the
+column lines of the row it has selected, as on the piano. A scan runs
+every msec (as in app.cpp) and each key is sampled every KEY_ROWS scans.
+
+Each intended press is modelled as:
+
+- contact bounce on closing and on opening: random toggles for up to the
+  bounce time.
+- chatter while held: brief openings at random (a dancer's weight shifting
+  on the key).
+
+The presses are either stomps (a key at a time, random lengths) or slides
+(a dancer sliding across neighbouring keys, each pressed before the last
+is released), or a mix.
+
+Bounce and chatter shorter than the 7 msec sample period mostly fall
+between samples, so without model options keysim also runs the CASES
+below, whose openings span one or more sample periods. A sweep where
+no setting lets a bounce through (no double or false key_down()) gets a
+warning: it didn't test the debounce.
+
+For each debounce setting the report has:
+
+- down latency: press start to the key_down() call, percentiles (msec).
+- up latency: release start to the key_up() call.
+- missed: presses with no key_down().
+- double: extra key_down() calls within a press.
+- false: key_down() calls outside any press.
+
+usage: keysim [-n presses] [-m stomp|slide|mix] [-b bounce_usec]
+              [-c chatter_per_sec] [-w chatter_usec] [-l min_hold_msec]
+              [-s seed]
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hal.h"
+#include "common.h"
+#include "key.h"
+
+//-----------------------------------------------------------------------------
+
+#define SIM_MAX_PRESSES 4096
+#define SIM_MAX_EDGES (SIM_MAX_PRESSES * 64)
+#define SIM_MAX_EVENTS (SIM_MAX_PRESSES * 8)
+
+#define SIM_SCAN_USEC 1000      // key_scan period
+#define SIM_KEY_GAP_USEC 60000  // minimum time between presses of a key
+#define SIM_GRACE_USEC 100000   // a press owns key_down() calls until this long after release
+
+// intended press
+typedef struct press {
+    uint8_t key;
+    uint32_t start;         // usec
+    uint32_t release;
+    uint32_t end;           // release + bounce
+    uint16_t downs;         // key_down() calls attributed to this press
+    uint32_t down_usec;     // first key_down()
+    uint32_t up_usec;       // last key_up()
+} PRESS;
+
+// contact change
+typedef struct edge {
+    uint32_t usec;
+    uint32_t seq;           // generated order, for edges at the same time
+    uint8_t key;
+    uint8_t closed;
+} EDGE;
+
+// key_down()/key_up() call
+typedef struct event {
+    uint32_t usec;
+    uint8_t key;
+    uint8_t down;
+} EVENT;
+
+// model parameters
+static int sim_presses = 1000;
+static int sim_mode = 2;                // 0 stomp, 1 slide, 2 mix
+static uint32_t sim_bounce = 3000;      // usec
+static uint32_t sim_chatter = 2;        // openings per second while held
+static uint32_t sim_chatter_usec = 800; // longest opening
+static uint32_t sim_hold_min = 30;      // msec
+static unsigned sim_seed = 1;
+
+// extra runs when no model option is given
+typedef struct sim_case {
+    const char *name;
+    int mode;
+    uint32_t bounce;
+    uint32_t chatter;
+    uint32_t chatter_usec;
+} SIM_CASE;
+
+static const SIM_CASE cases[] = {
+    {"slide, weight lifting off the keys", 1, 3000, 4, 15000},
+    {"mix, worn switches", 2, 10000, 2, 9000},
+};
+
+#define NUM_CASES (sizeof(cases) / sizeof(cases[0]))
+
+static PRESS presses[SIM_MAX_PRESSES];
+static int npresses;
+static EDGE edges[SIM_MAX_EDGES];
+static int nedges;
+static EVENT events[SIM_MAX_EVENTS];
+static int nevents;
+
+// playback state
+static uint32_t sim_usec;
+static int edge_posn;
+static uint8_t closed[NUM_KEYS];
+
+//-----------------------------------------------------------------------------
+// waveform generation
+
+static uint32_t rnd(uint32_t lo, uint32_t hi) {
+    return lo + (uint32_t)(((uint64_t)rand() * (hi - lo + 1)) / ((uint64_t)RAND_MAX + 1));
+}
+
+static void edge_add(uint32_t usec, uint8_t key, uint8_t c) {
+    if (nedges < SIM_MAX_EDGES) {
+        edges[nedges].usec = usec;
+        edges[nedges].seq = nedges;
+        edges[nedges].key = key;
+        edges[nedges].closed = c;
+        nedges += 1;
+    }
+}
+
+// toggle for up to the bounce time, ending in state c
+static uint32_t bounce(uint32_t usec, uint8_t key, uint8_t c) {
+    uint32_t end = usec + rnd(0, sim_bounce);
+    edge_add(usec, key, c);
+    while (1) {
+        uint32_t t = usec + rnd(30, 400);
+        if (t >= end) {
+            break;
+        }
+        edge_add(t, key, !c);
+        usec = t + rnd(30, 400);
+        edge_add(usec, key, c);
+    }
+    return usec;
+}
+
+static int press_add(uint8_t key, uint32_t start, uint32_t hold) {
+    static uint32_t key_free[NUM_KEYS];
+    if ((npresses >= SIM_MAX_PRESSES) || (start < key_free[key])) {
+        return -1;
+    }
+    PRESS *p = &presses[npresses ++];
+    memset(p, 0, sizeof(PRESS));
+    p->key = key;
+    p->start = start;
+    p->release = start + hold;
+
+    // closing
+    uint32_t t = bounce(start, key, 1);
+    // chatter while held
+    while (sim_chatter) {
+        t += rnd(1, 2000000 / sim_chatter);
+        if (t + sim_chatter_usec >= p->release) {
+            break;
+        }
+        edge_add(t, key, 0);
+        t += rnd(50, sim_chatter_usec);
+        edge_add(t, key, 1);
+    }
+    // opening
+    p->end = bounce(p->release, key, 0);
+    key_free[key] = p->end + SIM_KEY_GAP_USEC;
+    return 0;
+}
+
+static int edge_cmp(const void *a, const void *b) {
+    const EDGE *x = (const EDGE *)a;
+    const EDGE *y = (const EDGE *)b;
+    if (x->usec != y->usec) {
+        return (x->usec < y->usec) ? -1 : 1;
+    }
+    return (x->seq < y->seq) ? -1 : (x->seq > y->seq);
+}
+
+static void generate(void) {
+    uint32_t t = 100000;
+    srand(sim_seed);
+    npresses = 0;
+    nedges = 0;
+    while (npresses < sim_presses) {
+        int slide = (sim_mode == 1) || ((sim_mode == 2) && (rand() & 1));
+        if (slide) {
+            // across 3..6 neighbouring keys in either direction
+            int n = rnd(3, 6);
+            int dir = (rand() & 1) ? 1 : -1;
+            int key = (dir > 0) ? rnd(0, NUM_KEYS - n) : rnd(n - 1, NUM_KEYS - 1);
+            uint32_t s = t;
+            for (int i = 0; i < n; i ++) {
+                press_add(key, s, rnd(sim_hold_min, max(sim_hold_min, 150)) * 1000);
+                s += rnd(20, 60) * 1000;
+                key += dir;
+            }
+            t = s + rnd(100, 300) * 1000;
+        } else {
+            press_add(rnd(0, NUM_KEYS - 1), t, rnd(sim_hold_min, max(sim_hold_min, 400)) * 1000);
+            t += rnd(50, 300) * 1000;
+        }
+    }
+    qsort(edges, nedges, sizeof(EDGE), edge_cmp);
+}
+
+//-----------------------------------------------------------------------------
+// hal hooks
+
+// column lines for the selected row, closed switches read low
+static uint8_t sim_pin_in(uint8_t port) {
+    if (port != HAL_PORTC) {
+        return hal_host.port[port];
+    }
+    while ((edge_posn < nedges) && (edges[edge_posn].usec <= sim_usec)) {
+        closed[edges[edge_posn].key] = edges[edge_posn].closed;
+        edge_posn += 1;
+    }
+    uint8_t row = hal_host.port[HAL_PORTB] & 7;
+    uint8_t val = 0xff;
+    for (int col = 0; col < KEY_COLS; col ++) {
+        if ((row < KEY_ROWS) && closed[row + (col * KEY_ROWS)]) {
+            val &= ~(1 << col);
+        }
+    }
+    return val;
+}
+
+static void event_add(uint8_t key, uint8_t down) {
+    if (nevents < SIM_MAX_EVENTS) {
+        events[nevents].usec = sim_usec;
+        events[nevents].key = key;
+        events[nevents].down = down;
+        nevents += 1;
+    }
+}
+
+static void sim_key_down(uint8_t key) {
+    event_add(key, 1);
+}
+
+static void sim_key_up(uint8_t key) {
+    event_add(key, 0);
+}
+
+//-----------------------------------------------------------------------------
+// run and score a debounce setting
+
+typedef struct result {
+    uint8_t down;
+    uint8_t up;
+    uint32_t lat[4];        // down latency p50, p90, p99, max (usec)
+    uint32_t rel[2];        // up latency p50, max
+    int missed;
+    int doubles;
+    int falses;
+} RESULT;
+
+static uint32_t lat_buf[SIM_MAX_PRESSES];
+static uint32_t rel_buf[SIM_MAX_PRESSES];
+
+static int u32_cmp(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x < y) ? -1 : (x > y);
+}
+
+static uint32_t pct(uint32_t *buf, int n, int p) {
+    if (n == 0) {
+        return 0;
+    }
+    int i = (n * p) / 100;
+    return buf[(i < n) ? i : (n - 1)];
+}
+
+// the latest press of this key that owns time t, or 0
+static PRESS *press_find(uint8_t key, uint32_t t) {
+    PRESS *found = 0;
+    for (int i = 0; i < npresses; i ++) {
+        PRESS *p = &presses[i];
+        if ((p->key == key) && (t >= p->start) && (t < p->end + SIM_GRACE_USEC)) {
+            found = p;
+        }
+    }
+    return found;
+}
+
+static void run(RESULT *r) {
+    memset(closed, 0, sizeof(closed));
+    edge_posn = 0;
+    nevents = 0;
+    for (int i = 0; i < npresses; i ++) {
+        presses[i].downs = 0;
+        presses[i].down_usec = 0;
+        presses[i].up_usec = 0;
+    }
+
+    key_init();
+    keys.debounce_down = r->down;
+    keys.debounce_up = r->up;
+    keys.key_down = sim_key_down;
+    keys.key_up = sim_key_up;
+
+    uint32_t end = presses[npresses - 1].end + SIM_GRACE_USEC;
+    for (sim_usec = 0; sim_usec < end; sim_usec += SIM_SCAN_USEC) {
+        key_scan();
+    }
+
+    // attribute the calls to the presses
+    r->falses = 0;
+    for (int i = 0; i < nevents; i ++) {
+        EVENT *e = &events[i];
+        PRESS *p = press_find(e->key, e->usec);
+        if (!p) {
+            r->falses += e->down;
+            continue;
+        }
+        if (e->down) {
+            if (p->downs == 0) {
+                p->down_usec = e->usec;
+            }
+            p->downs += 1;
+        } else if (e->usec >= p->release) {
+            p->up_usec = e->usec;
+        }
+    }
+
+    int nlat = 0;
+    int nrel = 0;
+    r->missed = 0;
+    r->doubles = 0;
+    for (int i = 0; i < npresses; i ++) {
+        PRESS *p = &presses[i];
+        if (p->downs == 0) {
+            r->missed += 1;
+            continue;
+        }
+        r->doubles += p->downs - 1;
+        lat_buf[nlat ++] = p->down_usec - p->start;
+        if (p->up_usec) {
+            rel_buf[nrel ++] = p->up_usec - p->release;
+        }
+    }
+    qsort(lat_buf, nlat, sizeof(uint32_t), u32_cmp);
+    qsort(rel_buf, nrel, sizeof(uint32_t), u32_cmp);
+    r->lat[0] = pct(lat_buf, nlat, 50);
+    r->lat[1] = pct(lat_buf, nlat, 90);
+    r->lat[2] = pct(lat_buf, nlat, 99);
+    r->lat[3] = nlat ? lat_buf[nlat - 1] : 0;
+    r->rel[0] = pct(rel_buf, nrel, 50);
+    r->rel[1] = nrel ? rel_buf[nrel - 1] : 0;
+}
+
+//-----------------------------------------------------------------------------
+
+static const uint8_t try_down[] = {0, 1, 2, 3, 4};
+static const uint8_t try_up[] = {0, 1, 2, 4, 6, 8};
+
+#define NUM_TRY_DOWN (sizeof(try_down) / sizeof(try_down[0]))
+#define NUM_TRY_UP (sizeof(try_up) / sizeof(try_up[0]))
+
+static const char *mode_names[] = {"stomp", "slide", "mix"};
+
+// run every debounce setting against the current model
+static void sweep(const char *name) {
+    generate();
+
+    printf("%s: %d presses (%s), bounce %u us, chatter %u/s up to %u us, hold >= %u ms, %d edges\n",
+        name, npresses, mode_names[sim_mode], sim_bounce, sim_chatter,
+        sim_chatter_usec, sim_hold_min, nedges);
+    printf("scan %u us, each key sampled every %u us\n\n", SIM_SCAN_USEC, SIM_SCAN_USEC * KEY_ROWS);
+    printf("  down  up |  down latency ms p50  p90  p99  max |  up ms p50  max | missed double false\n");
+
+    RESULT best;
+    int have_best = 0;
+    int bounced = 0;
+    memset(&best, 0, sizeof(best));
+    for (unsigned i = 0; i < NUM_TRY_DOWN; i ++) {
+        for (unsigned j = 0; j < NUM_TRY_UP; j ++) {
+            RESULT r;
+            memset(&r, 0, sizeof(r));
+            r.down = try_down[i];
+            r.up = try_up[j];
+            run(&r);
+            int dflt = (r.down == KEY_DEBOUNCE_DOWN) && (r.up == KEY_DEBOUNCE_UP);
+            printf("%c %4u %3u |                 %4.0f %4.0f %4.0f %4.0f |        %4.0f %4.0f | %6d %6d %5d\n",
+                dflt ? '*' : ' ', r.down, r.up, r.lat[0] / 1e3, r.lat[1] / 1e3, r.lat[2] / 1e3,
+                r.lat[3] / 1e3, r.rel[0] / 1e3, r.rel[1] / 1e3, r.missed, r.doubles, r.falses);
+            bounced |= (r.doubles != 0) || (r.falses != 0);
+            if ((r.missed != 0) || (r.doubles != 0) || (r.falses != 0)) {
+                continue;
+            }
+            // the lowest p99 press latency, then the lowest release latency
+            if (!have_best || (r.lat[2] < best.lat[2]) ||
+                ((r.lat[2] == best.lat[2]) && (r.rel[1] < best.rel[1]))) {
+                best = r;
+                have_best = 1;
+            }
+        }
+    }
+    printf("\n* = firmware default (KEY_DEBOUNCE_DOWN %d, KEY_DEBOUNCE_UP %d)\n", KEY_DEBOUNCE_DOWN, KEY_DEBOUNCE_UP);
+    if (have_best) {
+        printf("fastest glitch free: down %u up %u\n", best.down, best.up);
+    } else {
+        printf("no setting was glitch free\n");
+    }
+    if (!bounced) {
+        printf("warning: no setting let a bounce through, the waveforms didn't test the debounce"
+            " (bounce or chatter longer than %u us will)\n", SIM_SCAN_USEC * KEY_ROWS);
+    }
+    printf("\n");
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "usage: %s [-n presses] [-m stomp|slide|mix] [-b bounce_usec]\n"
+        "          [-c chatter_per_sec] [-w chatter_usec] [-l min_hold_msec] [-s seed]\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+    int c;
+    int model = 0;      // model given on the command line
+
+    while ((c = getopt(argc, argv, "n:m:b:c:w:l:s:")) != -1) {
+        switch (c) {
+            case 'n': sim_presses = atoi(optarg); break;
+            case 'b': sim_bounce = strtoul(optarg, 0, 0); model = 1; break;
+            case 'c': sim_chatter = strtoul(optarg, 0, 0); model = 1; break;
+            case 'w': sim_chatter_usec = strtoul(optarg, 0, 0); model = 1; break;
+            case 'l': sim_hold_min = strtoul(optarg, 0, 0); break;
+            case 's': sim_seed = strtoul(optarg, 0, 0); break;
+            case 'm': {
+                sim_mode = !strcmp(optarg, "stomp") ? 0 : !strcmp(optarg, "slide") ? 1 : 2;
+                model = 1;
+                break;
+            }
+            default: {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+    }
+    if ((sim_presses < 1) || (sim_presses > SIM_MAX_PRESSES) || (sim_chatter_usec < 50)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    hal_host_init();
+    hal_host.pin_in = sim_pin_in;
+    sweep("model");
+    if (!model) {
+        for (unsigned i = 0; i < NUM_CASES; i ++) {
+            sim_mode = cases[i].mode;
+            sim_bounce = cases[i].bounce;
+            sim_chatter = cases[i].chatter;
+            sim_chatter_usec = cases[i].chatter_usec;
+            sweep(cases[i].name);
+        }
+    }
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,221 @@
+//-----------------------------------------------------------------------------
+/*
+
+LED Layer Compositor
+
+Several layer frame buffers are blended, bottom to top, into the led frame.
+
+The background layer has a pixel per led and holds the current effect.
+The key, midi and overlay layers have a pixel per key (LEDS_PER_KEY
+leds), which halves their SRAM cost. The layers take 168 + 3 * 84 = 420
+bytes on top of the 168 byte led frame.
+
+The effect render loop composes the whole frame once per led update.
+layer_set() composes just the leds of the pixel it changes, so a key
+light is shown at the next led update without waiting for a whole frame
+to be rendered.
+
+All blending is 8 bit integer arithmetic, one kernel per mode.
+
+The compose writes the led frame in place, so the led isr can send a
+frame that is half composed (tearing). Each kernel charges the host model
+LAYER_PIXEL_USEC a pixel (hal_work), so the host build's interrupts land
+in the middle of a compose too and its capture shows the tearing.
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+
+#include "hal.h"
+#include "color.h"
+#include "led.h"
+#include "layer.h"
+
+//-----------------------------------------------------------------------------
+
+#if (LEDS_PER_KEY != 2)
+#error "key layer resolution assumes 2 leds per key"
+#endif
+
+#define KEY_SHIFT 1
+
+// rough cost of one pixel of one layer on the device
+#define LAYER_PIXEL_USEC 2
+
+static RGB bg_fb[NUM_LEDS];
+static RGB key_fb[NUM_LEDS >> KEY_SHIFT];
+static RGB midi_fb[NUM_LEDS >> KEY_SHIFT];
+static RGB overlay_fb[NUM_LEDS >> KEY_SHIFT];
+
+static const LAYER layer_table[NUM_LAYERS] PROGMEM = {
+    {bg_fb, 0},
+    {key_fb, KEY_SHIFT},
+    {midi_fb, KEY_SHIFT},
+    {overlay_fb, KEY_SHIFT},
+};
+
+// the blend settings, the only layer state that changes
+static struct layer_blend {
+    uint8_t mode;
+    uint8_t alpha;      // for BLEND_ALPHA
+} blend[NUM_LAYERS];
+
+//-----------------------------------------------------------------------------
+// blend kernels: blend layer l into out[first..first+count)
+
+static void blend_replace(RGB *out, const LAYER *l, uint8_t first, uint8_t count) {
+    for (uint8_t i = first; i < first + count; i ++) {
+        hal_work(LAYER_PIXEL_USEC);
+        const RGB *p = &l->fb[i >> l->shift];
+        if (p->r | p->g | p->b) {
+            out[i] = *p;
+        }
+    }
+}
+
+static void blend_add(RGB *out, const LAYER *l, uint8_t first, uint8_t count) {
+    for (uint8_t i = first; i < first + count; i ++) {
+        hal_work(LAYER_PIXEL_USEC);
+        const RGB *p = &l->fb[i >> l->shift];
+        uint16_t r = out[i].r + p->r;
+        uint16_t g = out[i].g + p->g;
+        uint16_t b = out[i].b + p->b;
+        out[i].r = (r > 255) ? 255 : r;
+        out[i].g = (g > 255) ? 255 : g;
+        out[i].b = (b > 255) ? 255 : b;
+    }
+}
+
+static void blend_max(RGB *out, const LAYER *l, uint8_t first, uint8_t count) {
+    for (uint8_t i = first; i < first + count; i ++) {
+        hal_work(LAYER_PIXEL_USEC);
+        const RGB *p = &l->fb[i >> l->shift];
+        if (p->r > out[i].r) {
+            out[i].r = p->r;
+        }
+        if (p->g > out[i].g) {
+            out[i].g = p->g;
+        }
+        if (p->b > out[i].b) {
+            out[i].b = p->b;
+        }
+    }
+}
+
+static void blend_alpha(RGB *out, const LAYER *l, uint8_t alpha, uint8_t first, uint8_t count) {
+    // p * a + o * (256 - a) <= 255 * 256, so 16 bits is enough
+    uint16_t a = alpha;
+    uint16_t na = 256 - a;
+    for (uint8_t i = first; i < first + count; i ++) {
+        hal_work(LAYER_PIXEL_USEC);
+        const RGB *p = &l->fb[i >> l->shift];
+        out[i].r = ((p->r * a) + (out[i].r * na)) >> 8;
+        out[i].g = ((p->g * a) + (out[i].g * na)) >> 8;
+        out[i].b = ((p->b * a) + (out[i].b * na)) >> 8;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// compose leds first..first+count-1 into the led frame
+
+void layer_compose(uint8_t first, uint8_t count) {
+    RGB *out = led_frame();
+
+    if (first >= NUM_LEDS) {
+        return;
+    }
+    if (count > NUM_LEDS - first) {
+        count = NUM_LEDS - first;
+    }
+
+    // the background is opaque
+    for (uint8_t i = first; i < first + count; i ++) {
+        hal_work(LAYER_PIXEL_USEC);
+        out[i] = bg_fb[i];
+    }
+
+    for (uint8_t n = LAYER_BG + 1; n < NUM_LAYERS; n ++) {
+        if (blend[n].mode == BLEND_OFF) {
+            continue;
+        }
+        LAYER l;
+        memcpy_P(&l, &layer_table[n], sizeof(LAYER));
+        switch (blend[n].mode) {
+            case BLEND_REPLACE: {
+                blend_replace(out, &l, first, count);
+                break;
+            }
+            case BLEND_ADD: {
+                blend_add(out, &l, first, count);
+                break;
+            }
+            case BLEND_MAX: {
+                blend_max(out, &l, first, count);
+                break;
+            }
+            case BLEND_ALPHA: {
+                blend_alpha(out, &l, blend[n].alpha, first, count);
+                break;
+            }
+            default: {
+                break;
+            }
+        }
+    }
+    led_update();
+}
+
+//-----------------------------------------------------------------------------
+// layer access
+
+RGB *layer_fb(uint8_t layer) {
+    return (RGB *)pgm_read_ptr(&layer_table[layer].fb);
+}
+
+static uint8_t layer_shift(uint8_t layer) {
+    return pgm_read_byte(&layer_table[layer].shift);
+}
+
+uint8_t layer_pixels(uint8_t layer) {
+    return NUM_LEDS >> layer_shift(layer);
+}
+
+void layer_mode(uint8_t layer, uint8_t mode, uint8_t alpha) {
+    blend[layer].mode = mode;
+    blend[layer].alpha = alpha;
+}
+
+void layer_clear(uint8_t layer) {
+    memset(layer_fb(layer), 0, layer_pixels(layer) * sizeof(RGB));
+}
+
+// set a pixel and compose the leds it covers
+void layer_set(uint8_t layer, uint8_t px, const RGB *rgb) {
+    if (px >= layer_pixels(layer)) {
+        return;
+    }
+    layer_fb(layer)[px] = *rgb;
+    uint8_t shift = layer_shift(layer);
+    layer_compose(px << shift, 1 << shift);
+}
+
+//-----------------------------------------------------------------------------
+
+int layer_init(void) {
+    memset(bg_fb, 0, sizeof(bg_fb));
+    memset(key_fb, 0, sizeof(key_fb));
+    memset(midi_fb, 0, sizeof(midi_fb));
+    memset(overlay_fb, 0, sizeof(overlay_fb));
+
+    memset(blend, 0, sizeof(blend));
+    layer_mode(LAYER_BG, BLEND_REPLACE, 0);
+    // key presses punch through the background
+    layer_mode(LAYER_KEYS, BLEND_REPLACE, 0);
+    layer_mode(LAYER_MIDI, BLEND_REPLACE, 0);
+    layer_mode(LAYER_OVERLAY, BLEND_OFF, 255);
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
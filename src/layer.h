@@ -0,0 +1,55 @@
+//-----------------------------------------------------------------------------
+/*
+
+LED Layer Compositor
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef LAYER_H
+#define LAYER_H
+
+//-----------------------------------------------------------------------------
+// layers, bottom to top
+
+#define LAYER_BG        0   // background effect
+#define LAYER_KEYS      1   // key press lights
+#define LAYER_MIDI      2   // midi input lights
+#define LAYER_OVERLAY   3
+#define NUM_LAYERS      4
+
+//-----------------------------------------------------------------------------
+// blend modes
+
+#define BLEND_OFF       0   // layer not shown
+#define BLEND_REPLACE   1   // non-black pixels replace those below
+#define BLEND_ADD       2   // saturating add
+#define BLEND_MAX       3   // per channel maximum
+#define BLEND_ALPHA     4   // mix with those below, alpha/256 of this layer
+
+//-----------------------------------------------------------------------------
+
+// a layer's frame buffer and resolution (fixed, in program space)
+typedef struct layer {
+
+    RGB *fb;            // frame buffer
+    uint8_t shift;      // log2 of leds per pixel
+
+} LAYER;
+
+//-----------------------------------------------------------------------------
+// API functions
+
+int layer_init(void);
+RGB *layer_fb(uint8_t layer);
+uint8_t layer_pixels(uint8_t layer);
+void layer_mode(uint8_t layer, uint8_t mode, uint8_t alpha);
+void layer_clear(uint8_t layer);
+void layer_set(uint8_t layer, uint8_t px, const RGB *rgb);
+void layer_compose(uint8_t first, uint8_t count);
+
+//-----------------------------------------------------------------------------
+
+#endif // LAYER_H
+
+//-----------------------------------------------------------------------------
@@ -6,14 +6,26 @@ LCD Driver for HD44780 Style Devices
 This driver supports the 4 bit data, write only style of operation for minimal
 io pin usage.
 
+Writes go to a shadow copy of the display. lcd_flush() copies a few changed
+characters at a time to the device so that stdio output never blocks the
+caller for the ~100 us per character the display needs.
+
+The device setup is a state machine run by lcd_flush() as well, so
+lcd_init() doesn't wait for the 30 ms or so of power on and command
+delays. Output before the device is ready stays in the shadow display and
+is flushed after it.
+
 */
 //-----------------------------------------------------------------------------
 
-#include <avr/io.h>
-#include <util/delay.h>
 #include <stdio.h>
+#include <stdint.h>
 #include <string.h>
 
+#include "hal.h"
+#include "timer.h"
+#include "trace.h"
+
 #include "lcd.h"
 
 //-----------------------------------------------------------------------------
@@ -21,9 +33,26 @@ io pin usage.
 #define LCD_ROWS 2
 #define LCD_COLS 16
 
+// characters written per lcd_flush() call
+#define LCD_FLUSH_CHARS 4
+
+// device setup states
+enum {
+    LCD_POWER_ON,   // not started
+    LCD_RESET_1,    // waiting to send the reset sequence
+    LCD_RESET_2,
+    LCD_RESET_3,
+    LCD_CLEAR,      // waiting for the clear to finish
+    LCD_READY,
+};
+
 static struct lcd_shadow {
-    uint8_t row[LCD_COLS];
-    uint8_t col;
+    uint8_t row[LCD_ROWS][LCD_COLS];
+    uint32_t dirty;     // bit per character position
+    uint8_t col;        // stdio cursor column on row 1
+    uint8_t adr;        // device cursor position, 0xff = unknown
+    uint8_t state;      // device setup
+    uint32_t due;       // msec, end of the current setup delay
 } lcd;
 
 //-----------------------------------------------------------------------------
@@ -49,22 +78,22 @@ static struct lcd_shadow {
 // D6 - lcd d6
 // D7 - lcd d7
 
-#define LCD_DATA PORTD
-#define LCD_CTRL PORTD
-#define LCD_EN (1 << PORTD3)
-#define LCD_RS (1 << PORTD2)
+#define LCD_PORT HAL_PORTD
+#define LCD_DATA 0xf0
+#define LCD_EN (1 << 3)
+#define LCD_RS (1 << 2)
 
-#define LCD_RS_HI() (LCD_CTRL |= LCD_RS)
-#define LCD_RS_LO() (LCD_CTRL &= ~LCD_RS)
-#define LCD_EN_HI() (LCD_CTRL |= LCD_EN)
-#define LCD_EN_LO() (LCD_CTRL &= ~LCD_EN)
+#define LCD_RS_HI() hal_port_write(LCD_PORT, LCD_RS, LCD_RS)
+#define LCD_RS_LO() hal_port_write(LCD_PORT, LCD_RS, 0)
+#define LCD_EN_HI() hal_port_write(LCD_PORT, LCD_EN, LCD_EN)
+#define LCD_EN_LO() hal_port_write(LCD_PORT, LCD_EN, 0)
 
 static void lcd_wr(uint8_t val) {
     LCD_EN_HI();
-    LCD_DATA = (LCD_DATA & 0x0f) | (val & 0xf0);
-    _delay_us(5);
+    hal_port_write(LCD_PORT, LCD_DATA, val);
+    hal_delay_usec(5);
     LCD_EN_LO();
-    _delay_us(50);
+    hal_delay_usec(50);
 }
 
 //-----------------------------------------------------------------------------
@@ -73,7 +102,7 @@ static void lcd_wr(uint8_t val) {
 // write 8 bits to the instruction/command register
 static void lcd_cmd(uint8_t cmd) {
     LCD_RS_LO();
-    _delay_us(5);
+    hal_delay_usec(5);
     lcd_wr(cmd);
     lcd_wr(cmd << 4);
 }
@@ -81,7 +110,7 @@ static void lcd_cmd(uint8_t cmd) {
 // write 8 bits to the data register
 static void lcd_char(uint8_t ch) {
     LCD_RS_HI();
-    _delay_us(5);
+    hal_delay_usec(5);
     lcd_wr(ch);
     lcd_wr(ch << 4);
 }
@@ -90,28 +119,104 @@ static void lcd_char(uint8_t ch) {
 
 static void lcd_io_init(void) {
     // set the portd data and ctrl pins as outputs
-    DDRD |= (0xf0 | LCD_EN | LCD_RS);
+    hal_port_dir(LCD_PORT, LCD_DATA | LCD_EN | LCD_RS, 0xff);
     LCD_EN_LO();
 }
 
+//-----------------------------------------------------------------------------
+// shadow display
+
+// set a shadow character, mark it for flushing if it has changed
+static void lcd_set(uint8_t row, uint8_t col, uint8_t ch) {
+    if (lcd.row[row][col] != ch) {
+        lcd.row[row][col] = ch;
+        lcd.dirty |= 1UL << ((row * LCD_COLS) + col);
+    }
+}
+
+// wait at least msec (the current msec may be nearly over)
+static void lcd_wait(uint32_t now, uint8_t msec) {
+    lcd.due = now + msec + 1;
+}
+
+// 4 bit setup as per hd44780 datasheet, a step per call once its delay is over
+static void lcd_setup(void) {
+    uint32_t now = timer_get_msec();
+    if ((lcd.state != LCD_POWER_ON) && !timer_after(now, lcd.due)) {
+        return;
+    }
+    switch (lcd.state) {
+        case LCD_POWER_ON: {
+            lcd_wait(now, 20);
+            break;
+        }
+        case LCD_RESET_1: {
+            lcd_wr(0x30);
+            lcd_wait(now, 10);
+            break;
+        }
+        case LCD_RESET_2: {
+            lcd_wr(0x30);
+            lcd_wait(now, 1);
+            break;
+        }
+        case LCD_RESET_3: {
+            lcd_wr(0x30);
+            lcd_wr(0x20);
+            lcd_cmd(LCD_FUNCTION_SET);
+            lcd_cmd(LCD_DISPLAY_ON);
+            lcd_cmd(LCD_DISPLAY_CLEAR);
+            lcd_wait(now, 2);
+            break;
+        }
+        case LCD_CLEAR:
+        default: {
+            lcd_cmd(LCD_ENTRY_MODE_SET);
+            break;
+        }
+    }
+    lcd.state ++;
+}
+
+// set up the device or write some changed characters to it,
+// return non-zero if there is more to do
+int lcd_flush(void) {
+    if (lcd.state != LCD_READY) {
+        lcd_setup();
+        return 1;
+    }
+    if (lcd.dirty == 0) {
+        return 0;
+    }
+    TRACE(TRACE_LCD_START, 0, 0);
+    for (int n = 0; (n < LCD_FLUSH_CHARS) && lcd.dirty; n ++) {
+        uint8_t i = 0;
+        while ((lcd.dirty & (1UL << i)) == 0) {
+            i ++;
+        }
+        lcd.dirty &= ~(1UL << i);
+        if (lcd.adr != i) {
+            uint8_t row = i / LCD_COLS;
+            uint8_t col = i % LCD_COLS;
+            lcd_cmd((row ? LCD_ROW1 : LCD_ROW0) + col);
+        }
+        lcd_char(lcd.row[i / LCD_COLS][i % LCD_COLS]);
+        // the device auto increments (but not from the end of row 0 to row 1)
+        lcd.adr = ((i + 1) % LCD_COLS) ? (i + 1) : 0xff;
+    }
+    TRACE(TRACE_LCD_END, 0, lcd.dirty != 0);
+    return lcd.dirty != 0;
+}
+
 //-----------------------------------------------------------------------------
 // stdio compatible putc
 
 static void lcd_shift_up(void) {
-    int i;
-    // copy row 1 onto row 0 of the lcd
-    lcd_cmd(LCD_ROW0);
-    for (i = 0; i < LCD_COLS; i ++) {
-        lcd_char(lcd.row[i]);
-    }
-    // clear and display row 1
-    lcd_cmd(LCD_ROW1);
-    for (i = 0; i < LCD_COLS; i ++) {
-        lcd.row[i] = ' ';
-        lcd_char(' ');
+    // copy row 1 onto row 0, clear row 1
+    for (int i = 0; i < LCD_COLS; i ++) {
+        lcd_set(0, i, lcd.row[1][i]);
+        lcd_set(1, i, ' ');
     }
-    // back to row1, col0
-    lcd_cmd(LCD_ROW1);
     lcd.col = 0;
 }
 
@@ -121,8 +226,7 @@ int lcd_putc(char c, FILE *stream)
         lcd_shift_up();
     } else {
         if (lcd.col < LCD_COLS) {
-            lcd.row[lcd.col] = c;
-            lcd_char(c);
+            lcd_set(1, lcd.col, c);
             lcd.col += 1;
         }
     }
@@ -131,27 +235,16 @@ int lcd_putc(char c, FILE *stream)
 
 //-----------------------------------------------------------------------------
 
+// no delays here, lcd_flush() sets up the device
 int lcd_init(void) {
     lcd_io_init();
 
-    // 4 bit setup as per hd44780 datasheet
-    _delay_ms(20);
-    lcd_wr(0x30);
-    _delay_ms(10);
-    lcd_wr(0x30);
-    _delay_ms(1);
-    lcd_wr(0x30);
-    lcd_wr(0x20);
-
-    lcd_cmd(LCD_FUNCTION_SET);
-    lcd_cmd(LCD_DISPLAY_ON);
-    lcd_cmd(LCD_DISPLAY_CLEAR);
-    _delay_ms(2);
-    lcd_cmd(LCD_ENTRY_MODE_SET);
-
-    // initialise the shadow display
-    memset(lcd.row, ' ', LCD_COLS);
-    lcd_shift_up();
+    // initialise the shadow display (the device will be clear)
+    memset(lcd.row, ' ', sizeof(lcd.row));
+    lcd.dirty = 0;
+    lcd.col = 0;
+    lcd.adr = 0xff;
+    lcd.state = LCD_POWER_ON;
     return 0;
 }
 
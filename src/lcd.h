@@ -14,6 +14,7 @@ LCD Driver
 
 int lcd_init(void);
 int lcd_putc(char c, FILE *stream);
+int lcd_flush(void);
 
 //-----------------------------------------------------------------------------
 
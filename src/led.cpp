@@ -15,44 +15,39 @@ Or about 1.38 W/module maximum.
 
 #include <string.h>
 #include <stdint.h>
-#include <util/atomic.h>
 
+#include "hal.h"
 #include "color.h"
 #include "led.h"
 #include "timer.h"
-
-//-----------------------------------------------------------------------------
-// SPI bit assignments on port B
-
-#define SCK  5  // spi clock
-#define MISO 4  // master in, slave out
-#define MOSI 3  // master out, slave in
-#define SS   2  // slave select
-
-//-----------------------------------------------------------------------------
-
-#define SPI_TX(byte) (SPDR = byte)
-#define SPI_WAIT() while((SPSR & (1 << SPIF)) == 0)
+#include "midi.h"
+#include "trace.h"
 
 //-----------------------------------------------------------------------------
 // LED Control
 
 static RGB leds[NUM_LEDS];
 static int led_dirty;
+static volatile uint8_t led_frames;
+static LED_STATS led_stats;
 
 //-----------------------------------------------------------------------------
 // update the led chain
 
 void led_isr(void) {
+    led_frames ++;
     if (led_dirty < 0) {
         // no changes since last isr
+        led_stats.skipped ++;
         return;
     }
+    led_stats.pushed ++;
+    TRACE(TRACE_LED_PUSH, led_frames, led_dirty + 1);
     for (int i = 0; i <= led_dirty; i ++) {
         RGB *led = &leds[i];
-        SPI_TX(led->b); SPI_WAIT();
-        SPI_TX(led->r); SPI_WAIT();
-        SPI_TX(led->g); SPI_WAIT();
+        hal_spi_tx(led->b);
+        hal_spi_tx(led->r);
+        hal_spi_tx(led->g);
     }
     led_dirty = -1;
 }
@@ -76,6 +71,48 @@ RGB *led_get(int idx) {
     return &leds[idx];
 }
 
+//-----------------------------------------------------------------------------
+// whole frame access
+
+// The frame buffer can be written directly, followed by led_update().
+// Writing just after an update isr gives a full frame period before the
+// next one reads it.
+RGB *led_frame(void) {
+    return leds;
+}
+
+// mark the whole frame for update
+void led_update(void) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        led_dirty = NUM_LEDS - 1;
+    }
+    hal_frame_done();
+}
+
+// incremented by each update isr
+uint8_t led_frame_count(void) {
+    return led_frames;
+}
+
+void led_get_stats(LED_STATS *s) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        *s = led_stats;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// return the index of the first led for a midi note, -1 if it has no leds
+
+int led_note_index(uint8_t note) {
+    int white_note = midi_to_white(note);
+    int octave = midi_to_octave(note) - LED_BASE_OCTAVE;
+    if ((white_note < 0) || (octave < 0)) {
+        return -1;
+    }
+    int idx = ((octave * WHITE_KEYS_IN_OCTAVE) + white_note) * LEDS_PER_KEY;
+    return (idx < NUM_LEDS) ? idx : -1;
+}
+
 //-----------------------------------------------------------------------------
 // all leds off
 
@@ -92,25 +129,14 @@ int led_init(void) {
     // set all leds to off on the first update
     led_all_off();
 
-    // SPI bus setup
-    // ss, mosi, sck are outputs, ss is high
-    DDRB |= (1 << SCK) | (1 << MOSI) | (1 << SS);
-    PORTB |= (1 << SS);
-    // enable the spi in master mode - sets MISO to input
-    // set sck = fosc/4 (4MHz)
-    SPSR = 0;
-    SPCR = (1 << SPE) | (1 << MSTR);
+    // SPI bus setup, sck = fosc/4 (4MHz)
+    hal_spi_init();
 
     // use the 8 bit timer 0 to drive the led update isr
     // clock the counter at F_CPU / 1024 = 15625 Hz
     // interrupt at the overflow rate 2^8 / 15625 = 16.4 ms
     // gives led update rate around 60Hz
-    TCCR0A = 0;
-    TCCR0B = DIVIDE_BY_1024;
-    OCR0A = 0;
-    OCR0B = 0;
-    TIMSK0 = (1 << TOIE0);
-    TIFR0 = (1 << TOV0);
+    hal_frame_timer_init();
     return 0;
 }
 
@@ -16,6 +16,19 @@ Control the SPI based RGB LED Modules
 // number of leds in the chain
 // 4 octaves, 7 whites notes per octave, 2 leds per white note = 56 leds
 #define NUM_LEDS 56
+#define LEDS_PER_KEY 2
+
+// the octave of the lowest key (midi note 36)
+#define LED_BASE_OCTAVE 3
+
+//-----------------------------------------------------------------------------
+
+typedef struct led_stats {
+
+    uint16_t pushed;        // frames sent to the chain
+    uint16_t skipped;       // frames with no changes
+
+} LED_STATS;
 
 //-----------------------------------------------------------------------------
 // API functions
@@ -25,6 +38,11 @@ void led_isr(void);
 void led_set(int idx, const RGB *rgb);
 RGB *led_get(int idx);
 void led_all_off(void);
+RGB *led_frame(void);
+void led_update(void);
+uint8_t led_frame_count(void);
+void led_get_stats(LED_STATS *s);
+int led_note_index(uint8_t note);
 
 //-----------------------------------------------------------------------------
 
@@ -0,0 +1,120 @@
+//-----------------------------------------------------------------------------
+/*
+
+Key Lights
+
+Each key has a light on the key layer (local key presses) and one on the
+midi layer (received notes). Each light has a colour set by its note and
+an ADSR envelope scaled by the note velocity. light_render() steps all the
+envelopes once per led frame and writes the modulated colours into the
+layers.
+
+A note on steps its envelope immediately and composes the key so the
+attack starts at the next led update rather than a frame later.
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+
+#include "hal.h"
+#include "color.h"
+#include "led.h"
+#include "midi.h"
+#include "layer.h"
+#include "env.h"
+#include "light.h"
+
+//-----------------------------------------------------------------------------
+// envelope times
+
+#define ATTACK_MS   10
+#define DECAY_MS    250
+#define SUSTAIN     180 // 0..255
+#define RELEASE_MS  400
+
+//-----------------------------------------------------------------------------
+
+static const RGB note2color[WHITE_KEYS_IN_OCTAVE] PROGMEM = {
+    COLOR_RED,
+    COLOR_GREEN,
+    COLOR_BLUE,
+    COLOR_YELLOW,
+    COLOR_AQUA,
+    COLOR_FUCHSIA,
+    COLOR_WHITE
+};
+
+static struct light_control {
+    ENV_PARAMS params;
+    ENVELOPE env[2][NUM_LIGHTS];    // key and midi layers
+} lights;
+
+//-----------------------------------------------------------------------------
+
+static ENVELOPE *light_env(uint8_t layer, uint8_t key) {
+    return &lights.env[(layer == LAYER_KEYS) ? 0 : 1][key];
+}
+
+// the key colour modulated by a level
+static void light_color(RGB *rgb, uint8_t key, uint8_t level) {
+    memcpy_P(rgb, &note2color[key % WHITE_KEYS_IN_OCTAVE], sizeof(RGB));
+    rgb->r = (rgb->r * level) >> 8;
+    rgb->g = (rgb->g * level) >> 8;
+    rgb->b = (rgb->b * level) >> 8;
+}
+
+//-----------------------------------------------------------------------------
+
+void light_on(uint8_t layer, uint8_t note, uint8_t velocity) {
+    int led_num = led_note_index(note);
+    if (led_num < 0) {
+        return;
+    }
+    uint8_t key = led_num / LEDS_PER_KEY;
+    ENVELOPE *e = light_env(layer, key);
+    env_on(e, velocity);
+    RGB rgb;
+    light_color(&rgb, key, env_step(e, &lights.params));
+    layer_set(layer, key, &rgb);
+}
+
+void light_off(uint8_t layer, uint8_t note) {
+    int led_num = led_note_index(note);
+    if (led_num < 0) {
+        return;
+    }
+    env_off(light_env(layer, led_num / LEDS_PER_KEY));
+}
+
+//-----------------------------------------------------------------------------
+// step all envelopes, return non-zero if the layers changed
+
+int light_render(void) {
+    int changed = 0;
+    for (uint8_t n = 0; n < 2; n ++) {
+        RGB *fb = layer_fb(n ? LAYER_MIDI : LAYER_KEYS);
+        for (uint8_t key = 0; key < NUM_LIGHTS; key ++) {
+            ENVELOPE *e = &lights.env[n][key];
+            uint8_t stage = env_stage(e);
+            if ((stage == ENV_IDLE) || (stage == ENV_SUSTAIN)) {
+                // level is constant
+                continue;
+            }
+            light_color(&fb[key], key, env_step(e, &lights.params));
+            changed = 1;
+        }
+    }
+    return changed;
+}
+
+//-----------------------------------------------------------------------------
+
+int light_init(void) {
+    memset(&lights, 0, sizeof(lights));
+    env_config(&lights.params, ATTACK_MS, DECAY_MS, SUSTAIN, RELEASE_MS);
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
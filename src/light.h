@@ -0,0 +1,28 @@
+//-----------------------------------------------------------------------------
+/*
+
+Key Lights
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef LIGHT_H
+#define LIGHT_H
+
+//-----------------------------------------------------------------------------
+
+#define NUM_LIGHTS (NUM_LEDS / LEDS_PER_KEY)
+
+//-----------------------------------------------------------------------------
+// API functions
+
+int light_init(void);
+void light_on(uint8_t layer, uint8_t note, uint8_t velocity);
+void light_off(uint8_t layer, uint8_t note);
+int light_render(void);
+
+//-----------------------------------------------------------------------------
+
+#endif // LIGHT_H
+
+//-----------------------------------------------------------------------------
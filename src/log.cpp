@@ -0,0 +1,155 @@
+//-----------------------------------------------------------------------------
+/*
+
+Deferred Logging
+
+A log call queues a format id and two 16 bit arguments, the formatting
+and the stdio output happen later in log_run(), called when the scheduler
+is idle. On the key to midi path a log call is a few stores with
+interrupts off rather than a printf and string copies. Calls above
+LOG_LEVEL are compiled out, arguments and all.
+
+The formats are printf like, each conversion takes the next argument:
+
+%u  unsigned decimal
+%x  2 digit hex
+%N  a midi note: the number and its name ("61 C#/Db")
+%%  a percent sign
+
+If the queue is full the record is dropped, the number lost is printed
+before the next record that gets through.
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hal.h"
+#include "common.h"
+#include "midi.h"
+#include "log.h"
+
+//-----------------------------------------------------------------------------
+
+#if LOG_QUEUE_SIZE & (LOG_QUEUE_SIZE - 1)
+#error "LOG_QUEUE_SIZE must be a power of 2"
+#endif
+
+static const char fmt_key_down[] PROGMEM = "\ndn %N %u";
+static const char fmt_key_up[] PROGMEM = "\nup %N";
+static const char fmt_midi_on[] PROGMEM = "\nrx %N %u";
+static const char fmt_ram[] PROGMEM = "\nram %u stk %u";
+
+// in format id order
+static const char *const log_fmt[LOG_FORMATS] PROGMEM = {
+    fmt_key_down,
+    fmt_key_up,
+    fmt_midi_on,
+    fmt_ram,
+};
+
+//-----------------------------------------------------------------------------
+
+LOG_CTRL log_ctrl;
+
+//-----------------------------------------------------------------------------
+
+// queue a record
+void log_put(uint8_t id, uint16_t a, uint16_t b) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        uint8_t wr = log_ctrl.wr;
+        uint8_t next = inc_mod(wr, (LOG_QUEUE_SIZE - 1));
+        if (next == log_ctrl.rd) {
+            log_ctrl.dropped ++;
+        } else {
+            LOG_REC *r = &log_ctrl.queue[wr];
+            r->id = id;
+            r->a = a;
+            r->b = b;
+            log_ctrl.wr = next;
+            uint8_t depth = (next - log_ctrl.rd) & (LOG_QUEUE_SIZE - 1);
+            if (depth > log_ctrl.depth_max) {
+                log_ctrl.depth_max = depth;
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+static void log_print(const LOG_REC *r) {
+    const char *fmt = (const char *)pgm_read_ptr(&log_fmt[r->id]);
+    uint16_t arg[2] = {r->a, r->b};
+    uint8_t n = 0;
+    char c;
+    while ((c = pgm_read_byte(fmt ++)) != 0) {
+        if (c != '%') {
+            putchar(c);
+            continue;
+        }
+        c = pgm_read_byte(fmt ++);
+        if (c == '%') {
+            putchar(c);
+            continue;
+        }
+        if (c == 0) {
+            break;
+        }
+        unsigned int x = (n < 2) ? arg[n ++] : 0;
+        switch (c) {
+            case 'u': {
+                printf_P(PSTR("%u"), x);
+                break;
+            }
+            case 'x': {
+                printf_P(PSTR("%02x"), x);
+                break;
+            }
+            case 'N': {
+                char tmp[8];
+                printf_P(PSTR("%u %s"), x, midi_full_note_name(tmp, x));
+                break;
+            }
+            default: {
+                break;
+            }
+        }
+    }
+}
+
+// format one queued record, return non-zero if there was one
+int log_run(void) {
+    LOG_REC r;
+    uint16_t dropped = 0;
+    uint8_t empty = 1;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        if (log_ctrl.rd != log_ctrl.wr) {
+            r = log_ctrl.queue[log_ctrl.rd];
+            log_ctrl.rd = inc_mod(log_ctrl.rd, (LOG_QUEUE_SIZE - 1));
+            dropped = log_ctrl.dropped;
+            log_ctrl.dropped = 0;
+            empty = 0;
+        }
+    }
+    if (empty) {
+        return 0;
+    }
+    if (dropped) {
+        printf_P(PSTR("\nlog: %u lost"), dropped);
+    }
+    if (r.id < LOG_FORMATS) {
+        log_print(&r);
+    }
+    return 1;
+}
+
+//-----------------------------------------------------------------------------
+
+int log_init(void) {
+    memset(&log_ctrl, 0, sizeof(log_ctrl));
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
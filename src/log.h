@@ -0,0 +1,95 @@
+//-----------------------------------------------------------------------------
+/*
+
+Deferred Logging
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef LOG_H
+#define LOG_H
+
+//-----------------------------------------------------------------------------
+
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+
+// calls above this level are compiled out
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_QUEUE_SIZE 8    // records, 5 bytes each (must be a power of 2)
+
+// format ids, the strings are in log.cpp
+enum {
+    LOG_KEY_DOWN,   // note, downs
+    LOG_KEY_UP,     // note
+    LOG_MIDI_ON,    // note, velocity
+    LOG_RAM,        // free ram low water mark, stack high water mark
+    LOG_FORMATS,
+};
+
+//-----------------------------------------------------------------------------
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(id, a, b) log_put(id, a, b)
+#else
+#define LOG_ERROR(id, a, b) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(id, a, b) log_put(id, a, b)
+#else
+#define LOG_WARN(id, a, b) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(id, a, b) log_put(id, a, b)
+#else
+#define LOG_INFO(id, a, b) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(id, a, b) log_put(id, a, b)
+#else
+#define LOG_DEBUG(id, a, b) do {} while (0)
+#endif
+
+//-----------------------------------------------------------------------------
+
+typedef struct log_record {
+
+    uint8_t id;
+    uint16_t a;
+    uint16_t b;
+
+} LOG_REC;
+
+typedef struct log_control {
+
+    LOG_REC queue[LOG_QUEUE_SIZE];
+    uint8_t rd;
+    uint8_t wr;
+    uint16_t dropped;       // records lost to a full queue
+    uint8_t depth_max;      // queue high water mark
+
+} LOG_CTRL;
+
+extern LOG_CTRL log_ctrl;
+
+//-----------------------------------------------------------------------------
+// API functions
+
+int log_init(void);
+void log_put(uint8_t id, uint16_t a, uint16_t b);
+int log_run(void);
+
+//-----------------------------------------------------------------------------
+
+#endif // LOG_H
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,126 @@
+//-----------------------------------------------------------------------------
+/*
+
+MIDI Merge
+
+Forward the midi input to the midi output along with the notes from the
+keys, so the piano can sit in a midi chain without a merge box.
+
+The output is shared at message boundaries. Both the local notes
+(midi_tx) and the forwarded messages are written to the uart tx buffer
+whole, from the main loop, and always with a status byte, so running
+status on the input never depends on what went out before.
+
+Received messages are queued with a timestamp. merge_run() moves them to
+the tx buffer only while it holds fewer than MERGE_TX_BACKLOG bytes, so
+the backlog stays in the merge queue and a key press waits behind at
+most one forwarded message (and the bytes of its own), about 1 msec at
+31250 baud. Filling the tx buffer instead would put up to 60 bytes, 19
+msecs, ahead of a note. The trace and telemetry replies use the same
+test. Realtime bytes skip the queue and go to the head of the tx buffer -
+they may be sent between the bytes of any other message.
+
+System exclusive messages are not forwarded: they would have to be held
+whole to keep them out of the local notes, and the ones we see are for
+the piano (frame streaming).
+
+The latency is the time from the message being parsed to it being put in
+the tx buffer, which then holds at most a message ahead of it. With the
+queue depth high water mark it shows how far the output is behind the
+input.
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "common.h"
+#include "uart.h"
+#include "timer.h"
+#include "trace.h"
+#include "merge.h"
+
+//-----------------------------------------------------------------------------
+
+MERGE_CTRL merge;
+
+//-----------------------------------------------------------------------------
+
+static uint8_t merge_depth(void) {
+    return (merge.wr - merge.rd) & (MERGE_QUEUE_SIZE - 1);
+}
+
+// midi message callback: queue a received message
+void merge_message(const uint8_t *msg, uint8_t len) {
+    if (!merge.enable) {
+        return;
+    }
+    if (inc_mod(merge.wr, (MERGE_QUEUE_SIZE - 1)) == merge.rd) {
+        merge.dropped ++;
+        return;
+    }
+    MERGE_MSG *m = &merge.queue[merge.wr];
+    memcpy(m->msg, msg, len);
+    m->len = len;
+    m->stamp = (uint16_t)timer_get_usec();
+    merge.wr = inc_mod(merge.wr, (MERGE_QUEUE_SIZE - 1));
+    uint8_t depth = merge_depth();
+    if (depth > merge.depth_max) {
+        merge.depth_max = depth;
+    }
+    merge_run();
+}
+
+// midi realtime callback: send it now
+void merge_realtime(uint8_t c) {
+    if (!merge.enable) {
+        return;
+    }
+    uart_tx_urgent(c);
+    merge.realtime ++;
+}
+
+//-----------------------------------------------------------------------------
+
+// return non-zero if the tx buffer is short enough for a message that
+// is not a local note
+int merge_tx_ready(void) {
+    return uart_tx_depth() < MERGE_TX_BACKLOG;
+}
+
+// return non-zero if a queued message can be sent
+int merge_pending(void) {
+    if (merge.rd == merge.wr) {
+        return 0;
+    }
+    return merge_tx_ready();
+}
+
+// send the queued messages that fit
+void merge_run(void) {
+    while (merge_pending()) {
+        MERGE_MSG *m = &merge.queue[merge.rd];
+        for (uint8_t i = 0; i < m->len; i ++) {
+            uart_tx(m->msg[i]);
+        }
+        merge.latency = (uint16_t)timer_get_usec() - m->stamp;
+        TRACE(TRACE_MIDI_FWD, m->msg[0], (merge.latency < (255 << 6)) ? (merge.latency >> 6) : 255);
+        if (merge.latency > merge.latency_max) {
+            merge.latency_max = merge.latency;
+        }
+        merge.forwarded ++;
+        merge.rd = inc_mod(merge.rd, (MERGE_QUEUE_SIZE - 1));
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+int merge_init(void) {
+    memset(&merge, 0, sizeof(merge));
+    merge.enable = 1;
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
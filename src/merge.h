@@ -0,0 +1,61 @@
+//-----------------------------------------------------------------------------
+/*
+
+MIDI Merge
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef MERGE_H
+#define MERGE_H
+
+//-----------------------------------------------------------------------------
+
+#define MERGE_QUEUE_SIZE 8  // messages (must be a power of 2)
+
+// forwarded messages (and the device sysex replies) go to the tx buffer
+// only while it holds fewer bytes than this, about one message
+#define MERGE_TX_BACKLOG 3
+
+//-----------------------------------------------------------------------------
+
+typedef struct merge_msg {
+
+    uint8_t msg[3];
+    uint8_t len;
+    uint16_t stamp;         // usec (low 16 bits) when it was received
+
+} MERGE_MSG;
+
+typedef struct merge_control {
+
+    MERGE_MSG queue[MERGE_QUEUE_SIZE];
+    uint8_t rd;
+    uint8_t wr;
+    uint8_t enable;
+    uint8_t depth_max;      // queue high water mark
+    uint16_t forwarded;     // messages sent
+    uint16_t realtime;      // realtime bytes sent
+    uint16_t dropped;       // messages lost to a full queue
+    uint16_t latency;       // usecs from receive to send, last message
+    uint16_t latency_max;
+
+} MERGE_CTRL;
+
+extern MERGE_CTRL merge;
+
+//-----------------------------------------------------------------------------
+// API functions
+
+int merge_init(void);
+void merge_message(const uint8_t *msg, uint8_t len);
+void merge_realtime(uint8_t c);
+int merge_tx_ready(void);
+int merge_pending(void);
+void merge_run(void);
+
+//-----------------------------------------------------------------------------
+
+#endif // MERGE_H
+
+//-----------------------------------------------------------------------------
@@ -3,6 +3,9 @@
 
 Read MIDI stream and make note on/off calls.
 
+The receive parser handles running status, realtime bytes anywhere in
+the stream and passes system exclusive data through a byte at a time.
+
 */
 //-----------------------------------------------------------------------------
 
@@ -11,7 +14,10 @@ Read MIDI stream and make note on/off calls.
 #include <string.h>
 #include <stdlib.h>
 
+#include "hal.h"
 #include "uart.h"
+#include "bench.h"
+#include "trace.h"
 #include "midi.h"
 
 //-----------------------------------------------------------------------------
@@ -23,26 +29,25 @@ Read MIDI stream and make note on/off calls.
 MIDI_CTRL midi;
 
 //-----------------------------------------------------------------------------
-// note to name conversion
-// TODO - put strings into program space
+// note to name conversion (the names are in program space)
+
+#define NOTE_NAME_SIZE 3
 
-static const char *sharps[NOTES_IN_OCTAVE] = {"C","C#","D","D#","E","F","F#","G","G#","A","A#","B"};
-static const char *flats[NOTES_IN_OCTAVE] = {"C","Db","D","Eb","E","F","Gb","G","Ab","A","Bb","B"};
+static const char sharps[NOTES_IN_OCTAVE][NOTE_NAME_SIZE] PROGMEM = {"C","C#","D","D#","E","F","F#","G","G#","A","A#","B"};
+static const char flats[NOTES_IN_OCTAVE][NOTE_NAME_SIZE] PROGMEM = {"C","Db","D","Eb","E","F","Gb","G","Ab","A","Bb","B"};
 
-// convert a midi note to a name
+// convert a midi note to a name, returns a program space string
 const char *midi_note_name(uint8_t note, char mode) {
     note %= NOTES_IN_OCTAVE;
     return (mode == '#') ? sharps[note] : flats[note];
 }
 
-// return a note name with sharp and flat forms
+// return a note name with sharp and flat forms (str holds 6 bytes)
 char *midi_full_note_name(char *str, uint8_t note) {
-    const char *s_name = midi_note_name(note, '#');
-    const char *f_name = midi_note_name(note, 'b');
-    strcpy(str, s_name);
-    if (strcmp(s_name, f_name)) {
-        strcat(str, "/");
-        strcat(str, f_name);
+    memcpy_P(str, midi_note_name(note, '#'), NOTE_NAME_SIZE);
+    if (str[1] == '#') {
+        str[2] = '/';
+        memcpy_P(&str[3], midi_note_name(note, 'b'), NOTE_NAME_SIZE);
     }
     return str;
 }
@@ -57,88 +62,146 @@ int midi_to_octave(uint8_t note) {
 
 // return 0 - 6 for the white key notes, -1 for a black key
 int midi_to_white(uint8_t note) {
-    static const int8_t convert[NOTES_IN_OCTAVE] = {0,-1,1,-1,2,3,-1,4,-1,5,-1,6};
+    static const int8_t convert[NOTES_IN_OCTAVE] PROGMEM = {0,-1,1,-1,2,3,-1,4,-1,5,-1,6};
     note %= NOTES_IN_OCTAVE;
-    return convert[note];
+    return (int8_t)pgm_read_byte(&convert[note]);
 }
 
 // convert 0-6 white key notes into midi notes
 int white_to_midi(uint8_t white) {
-    static const int8_t convert[WHITE_KEYS_IN_OCTAVE] = {0,2,4,5,7,9,11};
+    static const int8_t convert[WHITE_KEYS_IN_OCTAVE] PROGMEM = {0,2,4,5,7,9,11};
     white %= WHITE_KEYS_IN_OCTAVE;
-    return convert[white];
+    return (int8_t)pgm_read_byte(&convert[white]);
 }
 
 //-----------------------------------------------------------------------------
 // Transmit midi note commands
 
 void midi_tx(uint8_t cmd, uint8_t note, uint8_t velocity) {
+    TRACE(TRACE_MIDI_TX, cmd, note);
     uart_tx(cmd);
     uart_tx(note & 0x7f);
     uart_tx(velocity & 0x7f);
 }
 
 //-----------------------------------------------------------------------------
-// Receive midi note commands. Call provided note on/off functions.
+// Receive midi messages. Call provided functions.
 
-enum {
-    MIDI_STATE_COMMAND,
-    MIDI_STATE_NOTE,
-    MIDI_STATE_VELOCITY,
-};
+// data bytes following a channel status byte (0x8n..0xen)
+static const uint8_t channel_len[7] PROGMEM = {2, 2, 2, 2, 1, 1, 2};
 
-void midi_rx(void) {
+// data bytes following a system common status byte (0xf0..0xf7)
+static const uint8_t common_len[8] PROGMEM = {0, 1, 2, 1, 0, 0, 0, 0};
 
-    if (uart_test_rx() == 0) {
-        return;
+static void midi_sysex_end(uint8_t c) {
+    if (midi.in_sysex) {
+        midi.in_sysex = 0;
+        if (midi.sysex) {
+            midi.sysex(c);
+        }
     }
+}
 
-    uint8_t rx = uart_rx();
-
-    switch (midi.state) {
-        case MIDI_STATE_COMMAND: {
-            uint8_t cmd = rx & 0xf0;
-            if ((cmd == NOTE_ON) || (cmd == NOTE_OFF)) {
-                midi.command = cmd;
-                midi.state = MIDI_STATE_NOTE;
+static void midi_message(void) {
+    uint8_t cmd = midi.status & 0xf0;
+    if (cmd == NOTE_ON) {
+        if (midi.data[1] == 0) {
+            // note on with zero velocity is a note off
+            if (midi.note_off) {
+                midi.note_off(midi.data[0], 0);
             }
-            break;
+        } else if (midi.note_on) {
+            midi.note_on(midi.data[0], midi.data[1]);
         }
-        case MIDI_STATE_NOTE: {
-            if ((rx & 0x80) == 0) {
-                midi.note = rx;
-                midi.state = MIDI_STATE_VELOCITY;
-            } else {
-                // not a valid note
-                midi.state = MIDI_STATE_COMMAND;
-            }
-            break;
+    } else if (cmd == NOTE_OFF) {
+        if (midi.note_off) {
+            midi.note_off(midi.data[0], midi.data[1]);
         }
-        case MIDI_STATE_VELOCITY: {
-            if ((rx & 0x80) == 0) {
-                if ((midi.command == NOTE_ON) && midi.note_on) {
-                    midi.note_on(midi.note, rx);
-                }
-                if ((midi.command == NOTE_OFF) && midi.note_off) {
-                    midi.note_off(midi.note, rx);
+    } else if (cmd == PROGRAM_CHANGE) {
+        if (midi.program_change) {
+            midi.program_change(midi.data[0]);
+        }
+    }
+}
+
+// feed one received byte to the parser
+void midi_rx_byte(uint8_t rx) {
+
+    if (rx >= MIDI_REALTIME) {
+        // realtime: leaves any message in progress alone
+        if (midi.realtime) {
+            midi.realtime(rx);
+        }
+        return;
+    }
+
+    if (rx & 0x80) {
+        // status byte, ends any sysex
+        midi_sysex_end((rx == SYSEX_END) ? SYSEX_END : SYSEX_ABORT);
+        midi.count = 0;
+        if (rx < SYSEX_START) {
+            // channel message, becomes the running status
+            midi.status = rx;
+            midi.need = pgm_read_byte(&channel_len[(rx >> 4) - 8]);
+        } else {
+            // system common, cancels the running status
+            midi.status = 0;
+            if (rx == SYSEX_START) {
+                midi.in_sysex = 1;
+                if (midi.sysex) {
+                    midi.sysex(SYSEX_START);
                 }
+            } else if ((rx == TUNE_REQUEST) && midi.message) {
+                midi.message(&rx, 1);
+            } else if (pgm_read_byte(&common_len[rx & 7]) != 0) {
+                // skip the data bytes
+                midi.status = rx;
+                midi.need = pgm_read_byte(&common_len[rx & 7]);
             }
-            midi.state = MIDI_STATE_COMMAND;
-            break;
         }
-        default: {
-            // ?
-            midi.state = MIDI_STATE_COMMAND;
-            break;
+        return;
+    }
+
+    // data byte
+    if (midi.in_sysex) {
+        if (midi.sysex) {
+            midi.sysex(rx);
         }
+        return;
+    }
+    if (midi.status == 0) {
+        // no status, discard
+        return;
+    }
+    midi.data[midi.count ++] = rx;
+    if (midi.count == midi.need) {
+        midi.count = 0;
+        TRACE(TRACE_MIDI_RX, midi.status, midi.data[0]);
+        if (midi.message) {
+            uint8_t msg[3] = {midi.status, midi.data[0], midi.data[1]};
+            midi.message(msg, midi.need + 1);
+        }
+        if (midi.status < SYSEX_START) {
+            midi_message();
+        } else {
+            midi.status = 0;
+        }
+    }
+}
+
+void midi_rx(void) {
+    if (uart_test_rx() == 0) {
+        return;
     }
+    BENCH_BEGIN(BENCH_MIDI_RX);
+    midi_rx_byte(uart_rx());
+    BENCH_END(BENCH_MIDI_RX);
 }
 
 //-----------------------------------------------------------------------------
 
 int midi_init(void) {
     memset(&midi, 0, sizeof(midi));
-    midi.state = MIDI_STATE_COMMAND;
     return 0;
 }
 
@@ -20,16 +20,37 @@ MIDI Processing
 
 #define NOTE_OFF 0x80
 #define NOTE_ON  0x90
+#define PROGRAM_CHANGE 0xc0
+#define SYSEX_START 0xf0
+#define SYSEX_END 0xf7
+#define TUNE_REQUEST 0xf6
+#define MIDI_REALTIME 0xf8 // 0xf8..0xff, may appear anywhere
+#define MIDI_CLOCK 0xf8
+#define MIDI_START 0xfa
+#define MIDI_CONTINUE 0xfb
+#define MIDI_STOP 0xfc
+
+// passed to the sysex callback when a message is cut short
+#define SYSEX_ABORT 0x80
 
 //-----------------------------------------------------------------------------
 
 typedef struct midi_control {
 
-    uint8_t state;
-    uint8_t command;
-    uint8_t note;
+    uint8_t status;     // running status, 0 if none
+    uint8_t need;       // data bytes in the message
+    uint8_t count;      // data bytes received
+    uint8_t data[2];
+    uint8_t in_sysex;
     void (*note_on)(uint8_t note, uint8_t velocity);
     void (*note_off)(uint8_t note, uint8_t velocity);
+    void (*program_change)(uint8_t program);
+    // called with SYSEX_START, each data byte, then SYSEX_END or SYSEX_ABORT
+    void (*sysex)(uint8_t c);
+    // called with each realtime byte
+    void (*realtime)(uint8_t c);
+    // called with each complete channel or system common message
+    void (*message)(const uint8_t *msg, uint8_t len);
 
 } MIDI_CTRL;
 
@@ -38,7 +59,7 @@ extern MIDI_CTRL midi;
 //-----------------------------------------------------------------------------
 // API functions
 
-const char *midi_note_name(uint8_t note, char mode);
+const char *midi_note_name(uint8_t note, char mode);    // in program space
 char *midi_full_note_name(char *str, uint8_t note);
 
 int midi_to_octave(uint8_t note);
@@ -47,6 +68,7 @@ int white_to_midi(uint8_t white);
 
 int midi_init(void);
 void midi_rx(void);
+void midi_rx_byte(uint8_t rx);
 void midi_tx(uint8_t cmd, uint8_t note, uint8_t velocity);
 
 //-----------------------------------------------------------------------------
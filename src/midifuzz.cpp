@@ -0,0 +1,534 @@
+//-----------------------------------------------------------------------------
+/*
+
+MIDI Parser Fuzz and Throughput Harness
+
+Feeds byte streams to midi_rx_byte() and checks every callback against
+a reference decoder written from the MIDI 1.0 spec:
+
+- realtime bytes (f8..ff) are passed on anywhere and change nothing.
+- a channel status (80..ef) sets the running status. Its data bytes
+  complete a message (c0 and d0 take one, the rest two), and further
+  data bytes repeat it.
+- f0 starts a sysex. Its data bytes are passed on and any status byte
+  ends it (f7 normally, anything else aborts it).
+- system common f1..f7 cancels the running status. f1, f2 and f3 take 1,
+  2 and 1 data bytes, and f6 has none.
+- data bytes with no status are dropped.
+- a note on with velocity 0 is a note off.
+
+usage:
+    midifuzz [-n streams] [-s seed]     random and adversarial streams
+    midifuzz -b [-t sec]                throughput
+
+With MIDIFUZZ_LIBFUZZER defined ("make midifuzz_lf", needs clang) it is
+a libFuzzer target instead, and each input is a stream.
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "uart.h"
+#include "midi.h"
+#include "trace.h"
+
+//-----------------------------------------------------------------------------
+// uart and trace stubs, the parser is fed directly
+
+void uart_tx(uint8_t c) {
+}
+
+int uart_test_rx(void) {
+    return 0;
+}
+
+uint8_t uart_rx(void) {
+    return 0;
+}
+
+void trace_event(uint8_t id, uint8_t a, uint8_t b) {
+}
+
+//-----------------------------------------------------------------------------
+// callback logs
+
+enum {
+    EV_NOTE_ON,
+    EV_NOTE_OFF,
+    EV_PROGRAM,
+    EV_SYSEX,
+    EV_REALTIME,
+    EV_MESSAGE,
+};
+
+typedef struct event {
+    uint8_t type;
+    uint8_t len;            // EV_MESSAGE
+    uint8_t data[3];
+} EVENT;
+
+#define LOG_MAX 65536
+
+typedef struct log {
+    EVENT ev[LOG_MAX];
+    int n;
+    int overflow;
+} LOG;
+
+static LOG dut_log;         // from midi.cpp
+static LOG ref_log;         // from the reference decoder
+
+static void log_add(LOG *log, uint8_t type, uint8_t a, uint8_t b, uint8_t c, uint8_t len) {
+    if (log->n >= LOG_MAX) {
+        log->overflow = 1;
+        return;
+    }
+    EVENT *e = &log->ev[log->n ++];
+    e->type = type;
+    e->len = len;
+    e->data[0] = a;
+    e->data[1] = b;
+    e->data[2] = c;
+}
+
+static void dut_note_on(uint8_t note, uint8_t vel) {
+    log_add(&dut_log, EV_NOTE_ON, note, vel, 0, 0);
+}
+
+static void dut_note_off(uint8_t note, uint8_t vel) {
+    log_add(&dut_log, EV_NOTE_OFF, note, vel, 0, 0);
+}
+
+static void dut_program(uint8_t prog) {
+    log_add(&dut_log, EV_PROGRAM, prog, 0, 0, 0);
+}
+
+static void dut_sysex(uint8_t c) {
+    log_add(&dut_log, EV_SYSEX, c, 0, 0, 0);
+}
+
+static void dut_realtime(uint8_t c) {
+    log_add(&dut_log, EV_REALTIME, c, 0, 0, 0);
+}
+
+static void dut_message(const uint8_t *msg, uint8_t len) {
+    log_add(&dut_log, EV_MESSAGE, msg[0], (len > 1) ? msg[1] : 0, (len > 2) ? msg[2] : 0, len);
+}
+
+static void dut_init(void) {
+    midi_init();
+    midi.note_on = dut_note_on;
+    midi.note_off = dut_note_off;
+    midi.program_change = dut_program;
+    midi.sysex = dut_sysex;
+    midi.realtime = dut_realtime;
+    midi.message = dut_message;
+    dut_log.n = 0;
+    dut_log.overflow = 0;
+}
+
+//-----------------------------------------------------------------------------
+// reference decoder
+
+static struct {
+    uint8_t status;         // running status or pending system common, 0 = none
+    uint8_t expect;         // data bytes the status takes
+    uint8_t have;
+    uint8_t data[2];
+    uint8_t sysex;          // inside f0 .. f7
+} ref;
+
+static void ref_init(void) {
+    memset(&ref, 0, sizeof(ref));
+    ref_log.n = 0;
+    ref_log.overflow = 0;
+}
+
+static int ref_data_len(uint8_t status) {
+    switch (status & 0xf0) {
+        case 0x80: case 0x90: case 0xa0: case 0xb0: case 0xe0: return 2;
+        case 0xc0: case 0xd0: return 1;
+    }
+    switch (status) {
+        case 0xf1: case 0xf3: return 1;
+        case 0xf2: return 2;
+    }
+    return 0;
+}
+
+static void ref_byte(uint8_t b) {
+    if (b >= 0xf8) {
+        log_add(&ref_log, EV_REALTIME, b, 0, 0, 0);
+        return;
+    }
+    if (b < 0x80) {
+        if (ref.sysex) {
+            log_add(&ref_log, EV_SYSEX, b, 0, 0, 0);
+            return;
+        }
+        if (!ref.status) {
+            return;
+        }
+        ref.data[ref.have ++] = b;
+        if (ref.have < ref.expect) {
+            return;
+        }
+        ref.have = 0;
+        log_add(&ref_log, EV_MESSAGE, ref.status, ref.data[0], ref.expect > 1 ? ref.data[1] : 0, ref.expect + 1);
+        switch (ref.status & 0xf0) {
+            case 0x90: {
+                uint8_t type = ref.data[1] ? EV_NOTE_ON : EV_NOTE_OFF;
+                log_add(&ref_log, type, ref.data[0], ref.data[1], 0, 0);
+                break;
+            }
+            case 0x80: log_add(&ref_log, EV_NOTE_OFF, ref.data[0], ref.data[1], 0, 0); break;
+            case 0xc0: log_add(&ref_log, EV_PROGRAM, ref.data[0], 0, 0, 0); break;
+            case 0xf0: ref.status = 0; break;   // no running status for system common
+        }
+        return;
+    }
+    // status byte
+    if (ref.sysex) {
+        ref.sysex = 0;
+        log_add(&ref_log, EV_SYSEX, (b == 0xf7) ? 0xf7 : 0x80, 0, 0, 0);
+    }
+    ref.have = 0;
+    ref.status = 0;
+    if (b == 0xf0) {
+        ref.sysex = 1;
+        log_add(&ref_log, EV_SYSEX, 0xf0, 0, 0, 0);
+    } else if (b == 0xf6) {
+        log_add(&ref_log, EV_MESSAGE, b, 0, 0, 1);
+    } else if (ref_data_len(b)) {
+        ref.status = b;
+        ref.expect = ref_data_len(b);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// compare
+
+static const char *ev_names[] = {"note_on", "note_off", "program", "sysex", "realtime", "message"};
+
+static void ev_print(const char *who, const EVENT *e) {
+    if (!e) {
+        printf("  %s: (none)\n", who);
+        return;
+    }
+    printf("  %s: %s %02x %02x %02x", who, ev_names[e->type], e->data[0], e->data[1], e->data[2]);
+    if (e->type == EV_MESSAGE) {
+        printf(" len %d", e->len);
+    }
+    printf("\n");
+}
+
+static int ev_equal(const EVENT *a, const EVENT *b) {
+    if ((a->type != b->type) || (a->data[0] != b->data[0])) {
+        return 0;
+    }
+    switch (a->type) {
+        case EV_NOTE_ON: case EV_NOTE_OFF: return a->data[1] == b->data[1];
+        case EV_MESSAGE: return (a->len == b->len) && !memcmp(a->data, b->data, a->len);
+    }
+    return 1;
+}
+
+// run a stream through both, return the index of the byte where they
+// first differ or -1
+static long check(const uint8_t *buf, size_t len) {
+    dut_init();
+    ref_init();
+    for (size_t i = 0; i < len; i ++) {
+        int d0 = dut_log.n;
+        int r0 = ref_log.n;
+        midi_rx_byte(buf[i]);
+        ref_byte(buf[i]);
+        if (dut_log.overflow || ref_log.overflow) {
+            // long input, start the logs again
+            dut_log.n = dut_log.overflow = 0;
+            ref_log.n = ref_log.overflow = 0;
+            continue;
+        }
+        int n = dut_log.n - d0;
+        int same = (n == (ref_log.n - r0));
+        for (int k = 0; same && (k < n); k ++) {
+            same = ev_equal(&dut_log.ev[d0 + k], &ref_log.ev[r0 + k]);
+        }
+        if (!same) {
+            int m = max(n, ref_log.n - r0);
+            for (int k = 0; k < m; k ++) {
+                ev_print("midi", (d0 + k < dut_log.n) ? &dut_log.ev[d0 + k] : 0);
+                ev_print("ref ", (r0 + k < ref_log.n) ? &ref_log.ev[r0 + k] : 0);
+            }
+            return i;
+        }
+    }
+    return -1;
+}
+
+//-----------------------------------------------------------------------------
+// stream generation
+
+static uint8_t rnd8(void) {
+    return rand() & 0xff;
+}
+
+static uint8_t rnd_data(void) {
+    return rand() & 0x7f;
+}
+
+static size_t put(uint8_t *buf, size_t n, size_t max, uint8_t c) {
+    if (n < max) {
+        buf[n ++] = c;
+    }
+    return n;
+}
+
+// random tokens, weighted to the awkward cases
+static size_t gen_stream(uint8_t *buf, size_t max) {
+    size_t n = 0;
+    int tokens = 1 + (rand() % 64);
+    // bias the whole stream to one of a few flavours
+    int rt_rate = rand() % 4;       // realtime interleaving
+    int noise = (rand() % 8) == 0;  // pure noise
+
+    for (int t = 0; t < tokens; t ++) {
+        if (noise) {
+            n = put(buf, n, max, rnd8());
+            continue;
+        }
+        switch (rand() % 10) {
+            case 0: case 1: case 2: {
+                // channel message, sometimes short, then running status
+                uint8_t s = 0x80 | (rand() & 0x7f);
+                if (s >= 0xf0) {
+                    s &= 0xef;
+                }
+                n = put(buf, n, max, s);
+                int runs = rand() % 4;
+                for (int r = 0; r < runs * 2 + (rand() % 2); r ++) {
+                    n = put(buf, n, max, rnd_data());
+                }
+                break;
+            }
+            case 3: {
+                // note on, including velocity 0
+                n = put(buf, n, max, 0x90 | (rand() & 15));
+                n = put(buf, n, max, rnd_data());
+                n = put(buf, n, max, (rand() & 1) ? 0 : rnd_data());
+                break;
+            }
+            case 4: case 5: {
+                // sysex, ended, aborted by a status, truncated or nested
+                n = put(buf, n, max, SYSEX_START);
+                int len = rand() % 40;
+                for (int i = 0; i < len; i ++) {
+                    n = put(buf, n, max, rnd_data());
+                }
+                switch (rand() % 4) {
+                    case 0: case 1: n = put(buf, n, max, SYSEX_END); break;
+                    case 2: n = put(buf, n, max, 0x80 | (rand() & 0x7f)); break;
+                    default: break;
+                }
+                break;
+            }
+            case 6: {
+                // system common with right or wrong data counts, stray f7
+                static const uint8_t common[] = {0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7};
+                n = put(buf, n, max, common[rand() % sizeof(common)]);
+                int len = rand() % 4;
+                for (int i = 0; i < len; i ++) {
+                    n = put(buf, n, max, rnd_data());
+                }
+                break;
+            }
+            case 7: {
+                // stray data bytes
+                int len = 1 + (rand() % 4);
+                for (int i = 0; i < len; i ++) {
+                    n = put(buf, n, max, rnd_data());
+                }
+                break;
+            }
+            case 8: {
+                // realtime burst
+                int len = 1 + (rand() % 3);
+                for (int i = 0; i < len; i ++) {
+                    n = put(buf, n, max, 0xf8 | (rand() & 7));
+                }
+                break;
+            }
+            default: {
+                n = put(buf, n, max, rnd8());
+                break;
+            }
+        }
+        // realtime inside the token just written
+        if (rt_rate && n && ((rand() % 4) < rt_rate)) {
+            size_t at = rand() % n;
+            if (n < max) {
+                memmove(&buf[at + 1], &buf[at], n - at);
+                buf[at] = MIDI_CLOCK;
+                n += 1;
+            }
+        }
+    }
+    return n;
+}
+
+//-----------------------------------------------------------------------------
+
+#if defined(MIDIFUZZ_LIBFUZZER)
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    if (check(data, size) >= 0) {
+        abort();
+    }
+    return 0;
+}
+
+#else
+
+//-----------------------------------------------------------------------------
+// throughput
+
+static volatile uint32_t sink;
+
+static void bench_note(uint8_t note, uint8_t vel) {
+    sink += note + vel;
+}
+
+static void bench_byte(uint8_t c) {
+    sink += c;
+}
+
+static void bench_message(const uint8_t *msg, uint8_t len) {
+    sink += len;
+}
+
+// typical traffic: notes with running status, clocks, stream frames
+static size_t gen_traffic(uint8_t *buf, size_t max) {
+    size_t n = 0;
+    while (n + 200 < max) {
+        int r = rand() % 10;
+        if (r < 6) {
+            n = put(buf, n, max, 0x90);
+            for (int i = 0; i < 4; i ++) {
+                n = put(buf, n, max, rnd_data());
+                n = put(buf, n, max, (i & 1) ? 0 : 100);
+            }
+        } else if (r < 8) {
+            n = put(buf, n, max, MIDI_CLOCK);
+        } else if (r < 9) {
+            n = put(buf, n, max, 0xc0);
+            n = put(buf, n, max, rnd_data());
+        } else {
+            n = put(buf, n, max, SYSEX_START);
+            for (int i = 0; i < 170; i ++) {
+                n = put(buf, n, max, rnd_data());
+            }
+            n = put(buf, n, max, SYSEX_END);
+        }
+    }
+    return n;
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + (ts.tv_nsec * 1e-9);
+}
+
+static void bench_run(const char *name, const uint8_t *buf, size_t len, double secs) {
+    uint64_t bytes = 0;
+    double t0 = now_sec();
+    double t;
+    do {
+        for (size_t i = 0; i < len; i ++) {
+            midi_rx_byte(buf[i]);
+        }
+        bytes += len;
+        t = now_sec() - t0;
+    } while (t < secs);
+    double rate = bytes / t;
+    // 31250 baud, 10 bits a byte
+    printf("%-12s %8.1f MB/s %6.2f ns/byte %10.0fx the wire rate\n", name, rate / 1e6, 1e9 / rate, rate / 3125.0);
+}
+
+static int bench(double secs) {
+    static uint8_t buf[1 << 16];
+    size_t len = gen_traffic(buf, sizeof(buf));
+
+    midi_init();
+    bench_run("no callbacks", buf, len, secs);
+
+    midi_init();
+    midi.note_on = bench_note;
+    midi.note_off = bench_note;
+    midi.program_change = bench_byte;
+    midi.sysex = bench_byte;
+    midi.realtime = bench_byte;
+    midi.message = bench_message;
+    bench_run("callbacks", buf, len, secs);
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    int streams = 100000;
+    unsigned seed = 1;
+    int do_bench = 0;
+    double secs = 1.0;
+    int c;
+
+    while ((c = getopt(argc, argv, "n:s:bt:")) != -1) {
+        switch (c) {
+            case 'n': streams = atoi(optarg); break;
+            case 's': seed = strtoul(optarg, 0, 0); break;
+            case 'b': do_bench = 1; break;
+            case 't': secs = atof(optarg); break;
+            default: {
+                fprintf(stderr, "usage: %s [-n streams] [-s seed] | -b [-t sec]\n", argv[0]);
+                return 1;
+            }
+        }
+    }
+    if (do_bench) {
+        return bench(secs);
+    }
+
+    static uint8_t buf[4096];
+    uint64_t bytes = 0;
+    srand(seed);
+    for (int i = 0; i < streams; i ++) {
+        size_t len = gen_stream(buf, sizeof(buf));
+        bytes += len;
+        long at = check(buf, len);
+        if (at >= 0) {
+            printf("stream %d (seed %u): mismatch at byte %ld\n", i, seed, at);
+            for (size_t k = 0; k < len; k ++) {
+                printf("%s%02x", (k == (size_t)at) ? " [" : " ", buf[k]);
+                if (k == (size_t)at) {
+                    printf("]");
+                }
+            }
+            printf("\n");
+            return 1;
+        }
+    }
+    printf("%d streams, %llu bytes: ok\n", streams, (unsigned long long)bytes);
+    return 0;
+}
+
+#endif // MIDIFUZZ_LIBFUZZER
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,124 @@
+//-----------------------------------------------------------------------------
+/*
+
+RAM Usage
+
+The ATmega328p has 2 KB of sram: the static data (.data and .bss) from the
+bottom, then the heap (unused, nothing calls malloc) and the stack growing
+down from the top. Nothing stops the stack running into the static data,
+so we measure how close it gets.
+
+ram_paint() runs from .init1, before the stack is used, and fills
+everything from the end of the static data to the top of ram with
+RAM_CANARY. The painted bytes the stack has never reached are still
+RAM_CANARY, counting them up from the end of the static data gives the
+deepest stack since reset (a stack byte that happens to hold RAM_CANARY
+can make the count a little low).
+
+ram_free() is the gap between the static data and the stack pointer now.
+ram_stats() (once a second from the stats task) latches it with the stack
+high water mark. The low water mark of the free ram comes from the paint
+too (size - stack_max): sampling ram_free() from a task would only ever
+see that task's stack depth, never the isrs nested on a deep call.
+
+The static data per module is reported from the elf at build time by
+tools/ramreport.py (make ramreport), which fails if it leaves less than
+RAM_STACK (400) bytes for the stack. The host build has none of this, the
+functions return 0.
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+
+#include "hal.h"
+#include "log.h"
+#include "ram.h"
+
+//-----------------------------------------------------------------------------
+
+RAM_CTRL ram;
+
+//-----------------------------------------------------------------------------
+
+#if defined(__AVR__)
+
+// linker symbols: the end of the static data and the initial stack pointer
+extern uint8_t __heap_start;
+extern uint8_t __stack;
+
+// No C here: .init1 runs before r1 is cleared and the stack pointer is set.
+void ram_paint(void) __attribute__((naked, used, section(".init1")));
+
+void ram_paint(void) {
+    __asm__ __volatile__ (
+        "    ldi r30, lo8(__heap_start)\n"
+        "    ldi r31, hi8(__heap_start)\n"
+        "    ldi r24, %0\n"
+        "    ldi r25, hi8(__stack)\n"
+        "    rjmp 2f\n"
+        "1:  st Z+, r24\n"
+        "2:  cpi r30, lo8(__stack)\n"
+        "    cpc r31, r25\n"
+        "    brlo 1b\n"
+        "    breq 1b\n"
+        :: "i" (RAM_CANARY)
+    );
+}
+
+// return the bytes between the static data and the stack pointer
+uint16_t ram_free(void) {
+    uint8_t top;
+    return &top - &__heap_start;
+}
+
+// return the painted bytes the stack has never reached
+uint16_t ram_stack_unused(void) {
+    const uint8_t *p = &__heap_start;
+    while ((p <= &__stack) && (*p == RAM_CANARY)) {
+        p ++;
+    }
+    return p - &__heap_start;
+}
+
+static uint16_t ram_size(void) {
+    return &__stack - &__heap_start + 1;
+}
+
+#else
+
+uint16_t ram_free(void) {
+    return 0;
+}
+
+uint16_t ram_stack_unused(void) {
+    return 0;
+}
+
+static uint16_t ram_size(void) {
+    return 0;
+}
+
+#endif // __AVR__
+
+//-----------------------------------------------------------------------------
+// latch the usage - run this from a periodic task
+
+void ram_stats(void) {
+    ram.free = ram_free();
+    ram.stack_max = ram.size - ram_stack_unused();
+    ram.free_min = ram.size - ram.stack_max;
+    LOG_DEBUG(LOG_RAM, ram.free_min, ram.stack_max);
+}
+
+//-----------------------------------------------------------------------------
+
+int ram_init(void) {
+    memset(&ram, 0, sizeof(ram));
+    ram.size = ram_size();
+    ram_stats();
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
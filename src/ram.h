@@ -0,0 +1,42 @@
+//-----------------------------------------------------------------------------
+/*
+
+RAM Usage
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef RAM_H
+#define RAM_H
+
+//-----------------------------------------------------------------------------
+
+// written over the free ram at reset
+#define RAM_CANARY 0xc5
+
+//-----------------------------------------------------------------------------
+
+typedef struct ram_control {
+
+    uint16_t size;          // between the end of the static data and the end of ram
+    uint16_t free;          // from the end of the static data to the stack pointer, last ram_stats()
+    uint16_t free_min;      // least free since reset (size - stack_max)
+    uint16_t stack_max;     // deepest stack since reset
+
+} RAM_CTRL;
+
+extern RAM_CTRL ram;
+
+//-----------------------------------------------------------------------------
+// API functions
+
+int ram_init(void);
+uint16_t ram_free(void);
+uint16_t ram_stack_unused(void);
+void ram_stats(void);
+
+//-----------------------------------------------------------------------------
+
+#endif // RAM_H
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,216 @@
+//-----------------------------------------------------------------------------
+/*
+
+Cooperative Task Scheduler
+
+Tasks are plain functions that do a bounded amount of work and return.
+
+Timed tasks are released at their due time and then either re-armed one
+period later (periodic) or removed (one-shot). Event tasks are released
+whenever their pending() function returns non-zero, or when they have been
+posted with sched_post() (which is safe to call from an isr).
+
+Each pass of the dispatcher runs the single most urgent released task:
+the lowest priority number wins, ties go to the earliest due time. If no
+task is released the idle function is called.
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+
+#include "hal.h"
+
+#include "timer.h"
+#include "sched.h"
+
+//-----------------------------------------------------------------------------
+
+SCHED_CTRL sched;
+
+//-----------------------------------------------------------------------------
+
+static int sched_alloc(void (*func)(void), uint8_t priority) {
+    for (int i = 0; i < SCHED_MAX_TASKS; i ++) {
+        SCHED_TASK *t = &sched.task[i];
+        if (t->func == 0) {
+            memset(t, 0, sizeof(SCHED_TASK));
+            t->func = func;
+            t->priority = priority;
+            return i;
+        }
+    }
+    return -1;
+}
+
+// add a timed task, first run after delay msecs. returns a task id or -1.
+int sched_add(void (*func)(void), uint16_t delay, uint16_t period, uint8_t priority) {
+    int id = sched_alloc(func, priority);
+    if (id >= 0) {
+        sched.task[id].due = timer_get_msec() + delay;
+        sched.task[id].period = period;
+    }
+    return id;
+}
+
+// add an event task. returns a task id or -1.
+int sched_add_event(void (*func)(void), int (*pending)(void), uint8_t priority) {
+    int id = sched_alloc(func, priority);
+    if (id >= 0) {
+        sched.task[id].pending = pending;
+    }
+    return id;
+}
+
+void sched_cancel(int id) {
+    if ((id < 0) || (id >= SCHED_MAX_TASKS)) {
+        return;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        sched.posted &= ~(1 << id);
+    }
+    sched.task[id].func = 0;
+}
+
+// release a task now
+void sched_post(int id) {
+    if ((id < 0) || (id >= SCHED_MAX_TASKS)) {
+        return;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        sched.posted |= (1 << id);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// run the most urgent released task. return non-zero if a task was run.
+
+int sched_run(void) {
+    uint32_t now = timer_get_msec();
+    uint8_t posted = sched.posted;
+    SCHED_TASK *best = 0;
+    int best_id = -1;
+
+    sched.loops ++;
+
+    for (int i = 0; i < SCHED_MAX_TASKS; i ++) {
+        SCHED_TASK *t = &sched.task[i];
+        if (t->func == 0) {
+            continue;
+        }
+        if (posted & (1 << i)) {
+            // posted tasks are due now
+        } else if (t->pending) {
+            if (!t->pending()) {
+                continue;
+            }
+        } else if (!timer_after(now, t->due)) {
+            continue;
+        }
+        if ((best == 0) || (t->priority < best->priority) ||
+            ((t->priority == best->priority) && timer_after(best->due, t->due))) {
+            best = t;
+            best_id = i;
+        }
+    }
+
+    if (best == 0) {
+        return 0;
+    }
+
+    if (posted & (1 << best_id)) {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            sched.posted &= ~(1 << best_id);
+        }
+    } else if (best->pending == 0) {
+        // timed task: account for lateness and re-arm
+        uint32_t late = now - best->due;
+        if (late > best->late_max) {
+            best->late_max = (late > 0xffff) ? 0xffff : late;
+        }
+        if (best->period) {
+            best->due += best->period;
+            if (timer_after(now, best->due)) {
+                // fell a whole period behind, resynchronise
+                best->misses ++;
+                best->due = now + best->period;
+            }
+        }
+    }
+
+    void (*func)(void) = best->func;
+    if ((best->pending == 0) && (best->period == 0) && ((posted & (1 << best_id)) == 0)) {
+        // one-shot: free the slot before running so it can re-add itself
+        best->func = 0;
+    }
+    best->runs ++;
+    func();
+    return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Return non-zero if a task is released now, otherwise set *due to the
+// earliest release time of the timed tasks (or now + 0xffff if there are
+// none). Used by the idle path with interrupts disabled.
+
+int sched_next_due(uint32_t *due) {
+    uint32_t now = timer_get_msec();
+    *due = now + 0xffff;
+
+    if (sched.posted) {
+        return 1;
+    }
+    for (int i = 0; i < SCHED_MAX_TASKS; i ++) {
+        SCHED_TASK *t = &sched.task[i];
+        if (t->func == 0) {
+            continue;
+        }
+        if (t->pending) {
+            if (t->pending()) {
+                return 1;
+            }
+        } else {
+            if (timer_after(now, t->due)) {
+                return 1;
+            }
+            if (timer_after(*due, t->due)) {
+                *due = t->due;
+            }
+        }
+    }
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+// latch the per second counters - run this as a 1000 ms periodic task
+
+void sched_stats(void) {
+    for (int i = 0; i < SCHED_MAX_TASKS; i ++) {
+        SCHED_TASK *t = &sched.task[i];
+        t->rate = t->runs;
+        t->runs = 0;
+    }
+    sched.loop_rate = sched.loops;
+    sched.loops = 0;
+}
+
+//-----------------------------------------------------------------------------
+// dispatch tasks forever
+
+void sched_loop(void) {
+    while (1) {
+        if (!sched_run() && sched.idle) {
+            sched.idle();
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+int sched_init(void) {
+    memset(&sched, 0, sizeof(sched));
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,69 @@
+//-----------------------------------------------------------------------------
+/*
+
+Cooperative Task Scheduler
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef SCHED_H
+#define SCHED_H
+
+//-----------------------------------------------------------------------------
+
+#define SCHED_MAX_TASKS 8
+
+// task priorities - lower numbers are more urgent
+#define SCHED_PRIO_SCAN     0
+#define SCHED_PRIO_MIDI     1
+#define SCHED_PRIO_TIMER    2
+#define SCHED_PRIO_LED      3
+#define SCHED_PRIO_LCD      4
+#define SCHED_PRIO_LOW      5
+
+//-----------------------------------------------------------------------------
+
+typedef struct sched_task {
+
+    void (*func)(void);     // task function, 0 = free slot
+    int (*pending)(void);   // event task: ready when this returns non-zero
+    uint32_t due;           // release time (msec)
+    uint16_t period;        // msec, 0 = one-shot
+    uint8_t priority;
+    uint16_t runs;          // runs in the current second
+    uint16_t rate;          // runs in the last second
+    uint16_t late_max;      // worst release to dispatch delay (msec)
+    uint16_t misses;        // whole periods skipped
+
+} SCHED_TASK;
+
+typedef struct sched_control {
+
+    SCHED_TASK task[SCHED_MAX_TASKS];
+    volatile uint8_t posted;    // bit per task, set by sched_post()
+    uint16_t loops;             // dispatcher passes in the current second
+    uint16_t loop_rate;         // dispatcher passes in the last second
+    void (*idle)(void);         // called when no task is ready
+
+} SCHED_CTRL;
+
+extern SCHED_CTRL sched;
+
+//-----------------------------------------------------------------------------
+// API functions
+
+int sched_init(void);
+int sched_add(void (*func)(void), uint16_t delay, uint16_t period, uint8_t priority);
+int sched_add_event(void (*func)(void), int (*pending)(void), uint8_t priority);
+void sched_cancel(int id);
+void sched_post(int id);
+int sched_run(void);
+int sched_next_due(uint32_t *due);
+void sched_stats(void);
+void sched_loop(void);
+
+//-----------------------------------------------------------------------------
+
+#endif // SCHED_H
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,367 @@
+//-----------------------------------------------------------------------------
+/*
+
+LED Frame Streaming over MIDI SysEx
+
+A host uploads whole or partial LED frames while the "host" effect is
+selected (select it with a program change). Messages are:
+
+F0 7D 01 <first> (<r> <g> <b>) ... F7      7 bit colour, 3 bytes per led
+F0 7D 02 <first> (<rrrrrgg> <gggbbbb>) ... F7 r5 g5 b4, 2 bytes per led
+F0 7D 03 F7                                 commit (flip) the frame
+
+Frame commands update the back buffer from led <first> onwards, for as
+many leds as there is data. Or'ing STREAM_FLIP into the command commits
+the frame when the message ends, saving a separate commit message. A
+message that is cut short by another status byte leaves whatever it wrote
+in the back buffer, but does not commit it.
+
+Bytes are written into the back buffer as they arrive, there is no
+message buffer. Commit copies the back buffer to the background layer, so
+a partial frame updates only the leds it covers.
+
+At 31250 baud a byte takes 320 usecs. A message has 5 bytes of overhead
+(F0 7D <cmd> <first> ... F7), so a full frame of 56 leds with STREAM_FLIP
+is 173 bytes (55.4 msec, 18.1 fps) as RGB7 or 117 bytes (37.4 msec, 26.7
+fps) as RGB554. With a separate commit message they are 177 bytes (17.7
+fps) and 121 bytes (25.8 fps). Partial frames cost 5 + 3 (or 2) bytes per
+led.
+
+Keyframes
+
+With the "host keys" effect selected the host sends target colours and
+the leds move toward them by themselves, once per led frame (61 Hz):
+
+F0 7D 04 <first> (<r> <g> <b> <time>) ... F7   a key per led
+F0 7D 05 <first> <count> <r> <g> <b> <time> F7 one key for count leds
+
+The time is in units of STREAM_KEY_FRAMES led frames (32.8 msec, so up
+to 4.2 secs) and 0 jumps straight to the target. Each led takes its key
+as soon as its bytes arrive. A fade of the whole keyboard is 10 bytes.
+
+Each led keeps its target and the frames left (3 bytes, the target is
+kept as RGB565, so it is the key colour to 5 or 6 bits), the current
+colour is the frame itself. Every frame a channel moves by d/n, where d
+is the distance to the target and n the frames left, using a table of
+16 bit reciprocals. There is no room to keep the fraction, so the step
+is rounded with a bias that runs through a low discrepancy sequence
+frame by frame: on average the motion is linear, and it lands exactly on
+the target in the last frame.
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+
+#include "hal.h"
+#include "common.h"
+#include "color.h"
+#include "led.h"
+#include "midi.h"
+#include "effect.h"
+#include "stream.h"
+
+//-----------------------------------------------------------------------------
+
+// back buffer, only while the host effect runs
+typedef struct stream_state {
+    RGB back[NUM_LEDS];
+    uint8_t changed;
+} STREAM_STATE;
+
+EFFECT_STATE_CHECK(STREAM_STATE);
+
+// keyframes, only while the host keys effect runs
+typedef struct keyframe {
+    uint8_t target[2];  // rrrrrggg gggbbbbb (bytes, so it packs on the host too)
+    uint8_t frames;     // frames left in the transition
+} KEYFRAME;
+
+typedef struct keyframe_state {
+    KEYFRAME key[NUM_LEDS];
+} KEYFRAME_STATE;
+
+EFFECT_STATE_CHECK(KEYFRAME_STATE);
+
+enum {
+    STREAM_IDLE,    // not our message
+    STREAM_MFR,     // expecting the manufacturer id
+    STREAM_CMD,     // expecting the command
+    STREAM_FIRST,   // expecting the first led
+    STREAM_COUNT,   // expecting the led count (STREAM_KEY_FILL)
+    STREAM_DATA,    // data, or the end of a commit
+};
+
+static struct stream_control {
+    RGB *frame;     // the effect frame, 0 if no host effect is running
+    uint8_t fx;     // index of the running host effect
+    uint8_t keys;   // the running host effect is host keys
+    uint8_t tick;   // frame counter for the keyframe rounding
+    uint8_t state;
+    uint8_t cmd;
+    uint8_t posn;   // byte offset into the back buffer, or led index
+    uint8_t count;  // leds to fill
+    uint8_t phase;  // byte within an led
+    uint8_t hold[3];
+} stream;
+
+//-----------------------------------------------------------------------------
+// frames
+
+static void stream_commit(void) {
+    STREAM_STATE *st = EFFECT_STATE(STREAM_STATE);
+    memcpy(stream.frame, st->back, sizeof(st->back));
+    st->changed = 1;
+}
+
+static void stream_frame_data(uint8_t c) {
+    uint8_t *back = (uint8_t *)EFFECT_STATE(STREAM_STATE)->back;
+    if (stream.posn >= NUM_LEDS * 3) {
+        return;
+    }
+    if ((stream.cmd & STREAM_CMD_MASK) == STREAM_RGB7) {
+        back[stream.posn ++] = (c << 1) | (c >> 6);
+        return;
+    }
+    // RGB554
+    if (stream.phase == 0) {
+        stream.hold[0] = c;
+        stream.phase = 1;
+        return;
+    }
+    uint8_t r = stream.hold[0] >> 2;
+    uint8_t g = ((stream.hold[0] & 3) << 3) | (c >> 4);
+    uint8_t b = c & 15;
+    back[stream.posn ++] = (r << 3) | (r >> 2);
+    back[stream.posn ++] = (g << 3) | (g >> 2);
+    back[stream.posn ++] = (b << 4) | b;
+    stream.phase = 0;
+}
+
+//-----------------------------------------------------------------------------
+// keyframes
+
+// 65536 / n, for n = 2..255
+static const uint16_t recip[256] PROGMEM = {
+    0x0000, 0x0000, 0x8000, 0x5555, 0x4000, 0x3333, 0x2aaa, 0x2492,
+    0x2000, 0x1c71, 0x1999, 0x1745, 0x1555, 0x13b1, 0x1249, 0x1111,
+    0x1000, 0x0f0f, 0x0e38, 0x0d79, 0x0ccc, 0x0c30, 0x0ba2, 0x0b21,
+    0x0aaa, 0x0a3d, 0x09d8, 0x097b, 0x0924, 0x08d3, 0x0888, 0x0842,
+    0x0800, 0x07c1, 0x0787, 0x0750, 0x071c, 0x06eb, 0x06bc, 0x0690,
+    0x0666, 0x063e, 0x0618, 0x05f4, 0x05d1, 0x05b0, 0x0590, 0x0572,
+    0x0555, 0x0539, 0x051e, 0x0505, 0x04ec, 0x04d4, 0x04bd, 0x04a7,
+    0x0492, 0x047d, 0x0469, 0x0456, 0x0444, 0x0432, 0x0421, 0x0410,
+    0x0400, 0x03f0, 0x03e0, 0x03d2, 0x03c3, 0x03b5, 0x03a8, 0x039b,
+    0x038e, 0x0381, 0x0375, 0x0369, 0x035e, 0x0353, 0x0348, 0x033d,
+    0x0333, 0x0329, 0x031f, 0x0315, 0x030c, 0x0303, 0x02fa, 0x02f1,
+    0x02e8, 0x02e0, 0x02d8, 0x02d0, 0x02c8, 0x02c0, 0x02b9, 0x02b1,
+    0x02aa, 0x02a3, 0x029c, 0x0295, 0x028f, 0x0288, 0x0282, 0x027c,
+    0x0276, 0x0270, 0x026a, 0x0264, 0x025e, 0x0259, 0x0253, 0x024e,
+    0x0249, 0x0243, 0x023e, 0x0239, 0x0234, 0x0230, 0x022b, 0x0226,
+    0x0222, 0x021d, 0x0219, 0x0214, 0x0210, 0x020c, 0x0208, 0x0204,
+    0x0200, 0x01fc, 0x01f8, 0x01f4, 0x01f0, 0x01ec, 0x01e9, 0x01e5,
+    0x01e1, 0x01de, 0x01da, 0x01d7, 0x01d4, 0x01d0, 0x01cd, 0x01ca,
+    0x01c7, 0x01c3, 0x01c0, 0x01bd, 0x01ba, 0x01b7, 0x01b4, 0x01b2,
+    0x01af, 0x01ac, 0x01a9, 0x01a6, 0x01a4, 0x01a1, 0x019e, 0x019c,
+    0x0199, 0x0197, 0x0194, 0x0192, 0x018f, 0x018d, 0x018a, 0x0188,
+    0x0186, 0x0183, 0x0181, 0x017f, 0x017d, 0x017a, 0x0178, 0x0176,
+    0x0174, 0x0172, 0x0170, 0x016e, 0x016c, 0x016a, 0x0168, 0x0166,
+    0x0164, 0x0162, 0x0160, 0x015e, 0x015c, 0x015a, 0x0158, 0x0157,
+    0x0155, 0x0153, 0x0151, 0x0150, 0x014e, 0x014c, 0x014a, 0x0149,
+    0x0147, 0x0146, 0x0144, 0x0142, 0x0141, 0x013f, 0x013e, 0x013c,
+    0x013b, 0x0139, 0x0138, 0x0136, 0x0135, 0x0133, 0x0132, 0x0130,
+    0x012f, 0x012e, 0x012c, 0x012b, 0x0129, 0x0128, 0x0127, 0x0125,
+    0x0124, 0x0123, 0x0121, 0x0120, 0x011f, 0x011e, 0x011c, 0x011b,
+    0x011a, 0x0119, 0x0118, 0x0116, 0x0115, 0x0114, 0x0113, 0x0112,
+    0x0111, 0x010f, 0x010e, 0x010d, 0x010c, 0x010b, 0x010a, 0x0109,
+    0x0108, 0x0107, 0x0106, 0x0105, 0x0104, 0x0103, 0x0102, 0x0101,
+};
+
+static void stream_key_set(uint8_t i, uint8_t time) {
+    KEYFRAME *k = &EFFECT_STATE(KEYFRAME_STATE)->key[i];
+    uint8_t r = stream.hold[0] >> 2;
+    uint8_t g = stream.hold[1] >> 1;
+    uint8_t b = stream.hold[2] >> 2;
+    k->target[0] = (r << 3) | (g >> 3);
+    k->target[1] = (g << 5) | b;
+    k->frames = time * STREAM_KEY_FRAMES;
+    if (k->frames == 0) {
+        // jump, next frame
+        k->frames = 1;
+    }
+}
+
+static void stream_key_data(uint8_t c) {
+    if (stream.phase < 3) {
+        stream.hold[stream.phase ++] = c;
+        return;
+    }
+    stream.phase = 0;
+    if ((stream.cmd & STREAM_CMD_MASK) == STREAM_KEY) {
+        if (stream.posn < NUM_LEDS) {
+            stream_key_set(stream.posn ++, c);
+        }
+        return;
+    }
+    // STREAM_KEY_FILL
+    while ((stream.count != 0) && (stream.posn < NUM_LEDS)) {
+        stream_key_set(stream.posn ++, c);
+        stream.count --;
+    }
+}
+
+// move x by about d/n toward t, rc = 65536/n, bias = rounding (0..65535)
+static uint8_t stream_lerp(uint8_t x, uint8_t t, uint16_t rc, uint16_t bias) {
+    if (t > x) {
+        return x + (uint8_t)((((uint32_t)(t - x) * rc) + bias) >> 16);
+    }
+    return x - (uint8_t)((((uint32_t)(x - t) * rc) + bias) >> 16);
+}
+
+//-----------------------------------------------------------------------------
+// midi sysex callback
+
+void stream_sysex(uint8_t c) {
+    if (c == SYSEX_START) {
+        int active = (stream.frame != 0) && (effect_current() == stream.fx);
+        stream.state = active ? STREAM_MFR : STREAM_IDLE;
+        stream.cmd = 0;
+        return;
+    }
+    if ((c == SYSEX_END) || (c == SYSEX_ABORT)) {
+        if ((c == SYSEX_END) && (stream.state == STREAM_DATA)) {
+            if ((stream.cmd == STREAM_COMMIT) || (stream.cmd & STREAM_FLIP)) {
+                stream_commit();
+            }
+        }
+        stream.state = STREAM_IDLE;
+        return;
+    }
+    switch (stream.state) {
+        case STREAM_MFR: {
+            stream.state = (c == STREAM_ID) ? STREAM_CMD : STREAM_IDLE;
+            break;
+        }
+        case STREAM_CMD: {
+            uint8_t cmd = c & STREAM_CMD_MASK;
+            stream.cmd = c;
+            stream.state = STREAM_IDLE;
+            if (c & ~(STREAM_CMD_MASK | STREAM_FLIP)) {
+                // another command set (trace.h)
+            } else if (stream.keys) {
+                if ((cmd == STREAM_KEY) || (cmd == STREAM_KEY_FILL)) {
+                    stream.cmd = cmd;
+                    stream.state = STREAM_FIRST;
+                }
+            } else if ((cmd == STREAM_RGB7) || (cmd == STREAM_RGB554)) {
+                stream.state = STREAM_FIRST;
+            } else if (cmd == STREAM_COMMIT) {
+                // no data
+                stream.posn = NUM_LEDS * 3;
+                stream.state = STREAM_DATA;
+            }
+            break;
+        }
+        case STREAM_FIRST: {
+            stream.phase = 0;
+            if (stream.keys) {
+                stream.posn = c;
+                stream.state = (stream.cmd == STREAM_KEY_FILL) ? STREAM_COUNT : STREAM_DATA;
+            } else {
+                stream.posn = (c < NUM_LEDS) ? c * 3 : NUM_LEDS * 3;
+                stream.state = STREAM_DATA;
+            }
+            break;
+        }
+        case STREAM_COUNT: {
+            stream.count = c;
+            stream.state = STREAM_DATA;
+            break;
+        }
+        case STREAM_DATA: {
+            if (stream.keys) {
+                stream_key_data(c);
+            } else {
+                stream_frame_data(c);
+            }
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// the host effect
+
+static void stream_start(RGB *frame, uint8_t keys) {
+    stream.frame = frame;
+    stream.fx = effect_current();
+    stream.keys = keys;
+    stream.state = STREAM_IDLE;
+}
+
+void stream_effect_init(RGB *frame, uint8_t arg) {
+    stream_start(frame, 0);
+}
+
+int stream_effect_render(RGB *frame, uint32_t t) {
+    STREAM_STATE *st = EFFECT_STATE(STREAM_STATE);
+    int changed = st->changed;
+    st->changed = 0;
+    return changed;
+}
+
+//-----------------------------------------------------------------------------
+// the host keys effect
+
+void stream_key_init(RGB *frame, uint8_t arg) {
+    stream_start(frame, 1);
+}
+
+// the RGB565 key target as 8 bit colour
+static void stream_key_target(RGB *rgb, const uint8_t *target) {
+    uint8_t r = target[0] >> 3;
+    uint8_t g = ((target[0] & 7) << 3) | (target[1] >> 5);
+    uint8_t b = target[1] & 0x1f;
+    rgb->r = (r << 3) | (r >> 2);
+    rgb->g = (g << 2) | (g >> 4);
+    rgb->b = (b << 3) | (b >> 2);
+}
+
+int stream_key_render(RGB *frame, uint32_t t) {
+    KEYFRAME *k = EFFECT_STATE(KEYFRAME_STATE)->key;
+    int changed = 0;
+
+    // rounding bias: the frame count bit reversed
+    uint8_t b = 0;
+    uint8_t tick = stream.tick ++;
+    for (uint8_t i = 0; i < 8; i ++) {
+        b = (b << 1) | (tick & 1);
+        tick >>= 1;
+    }
+    uint16_t bias = (uint16_t)b << 8;
+
+    for (uint8_t i = 0; i < NUM_LEDS; i ++, k ++) {
+        if (k->frames == 0) {
+            continue;
+        }
+        RGB target;
+        stream_key_target(&target, k->target);
+        if (k->frames == 1) {
+            frame[i] = target;
+        } else {
+            uint16_t rc = pgm_read_word(&recip[k->frames]);
+            frame[i].r = stream_lerp(frame[i].r, target.r, rc, bias);
+            frame[i].g = stream_lerp(frame[i].g, target.g, rc, bias);
+            frame[i].b = stream_lerp(frame[i].b, target.b, rc, bias);
+        }
+        k->frames --;
+        changed = 1;
+    }
+    return changed;
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,46 @@
+//-----------------------------------------------------------------------------
+/*
+
+LED Frame Streaming over MIDI SysEx
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef STREAM_H
+#define STREAM_H
+
+//-----------------------------------------------------------------------------
+// protocol: F0 7D <cmd> [<first led> <data> ...] F7
+
+#define STREAM_ID       0x7d    // non-commercial manufacturer id
+
+// commands
+#define STREAM_RGB7     0x01    // 3 bytes per led: r, g, b (7 bits each)
+#define STREAM_RGB554   0x02    // 2 bytes per led: r5 g5 b4 in 14 bits
+#define STREAM_COMMIT   0x03    // show the back buffer
+#define STREAM_KEY      0x04    // 4 bytes per led: r, g, b (7 bits each), time
+#define STREAM_KEY_FILL 0x05    // count, r, g, b, time: count leds to one key
+// the key colours are sent as 7 bits but kept as RGB565, so a key lands on
+// the colour to 5 bits of red and blue and 6 bits of green
+#define STREAM_CMD_MASK 0x0f
+
+// or'ed with a frame command: commit when the message ends
+#define STREAM_FLIP     0x10
+
+// keyframe time units (2 led frames, 32.8 msec), 0 jumps to the colour
+#define STREAM_KEY_FRAMES 2
+
+//-----------------------------------------------------------------------------
+// API functions
+
+void stream_sysex(uint8_t c);
+void stream_effect_init(RGB *frame, uint8_t arg);
+int stream_effect_render(RGB *frame, uint32_t t);
+void stream_key_init(RGB *frame, uint8_t arg);
+int stream_key_render(RGB *frame, uint32_t t);
+
+//-----------------------------------------------------------------------------
+
+#endif // STREAM_H
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,198 @@
+//-----------------------------------------------------------------------------
+/*
+
+Health Telemetry
+
+The counters and high water marks kept around the firmware (uart, key
+scan and scheduler rates, led frames, queues, ram, isr times), read out
+over the midi link so the piano can be watched from the desk while it
+plays. tools/telemon.py polls and graphs them.
+
+F0 7D 30 F7 asks for them, the reply is a message per page:
+
+F0 7D 30 <page> <n> <value> ... F7
+
+with n 16 bit values, each as 3 bytes of 7 bits, least significant first.
+The value indices are in telem.h. New values only go on the end of a
+page, so an older monitor still reads the ones it knows.
+
+Counters that wrap are sent as they are, the monitor takes the difference
+between polls. The rates are the scheduler's once a second figures.
+
+A page is at most 45 bytes, it goes out whole from the trace/telemetry
+task and only when the uart is nearly empty (merge_tx_ready()), so a
+local note waits behind at most one page, about 15 msecs. A request while
+a reply is going out is ignored.
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+
+#include "hal.h"
+#include "uart.h"
+#include "timer.h"
+#include "color.h"
+#include "led.h"
+#include "midi.h"
+#include "key.h"
+#include "sched.h"
+#include "idle.h"
+#include "merge.h"
+#include "log.h"
+#include "ram.h"
+#include "isrprof.h"
+#include "boot.h"
+#include "trace.h"
+#include "telem.h"
+
+//-----------------------------------------------------------------------------
+
+#define TELEM_PAGE_MAX 13
+
+#define TELEM_IDLE 0xff
+
+enum {
+    TELEM_RX_IDLE,      // not our message
+    TELEM_RX_MFR,       // expecting the manufacturer id
+    TELEM_RX_CMD,       // expecting the command
+    TELEM_RX_END,       // expecting the end
+};
+
+static struct telem_control {
+    uint8_t page;       // next page to send, TELEM_IDLE = none
+    uint8_t rx_state;
+} telem;
+
+//-----------------------------------------------------------------------------
+
+// return the last second's runs of a task
+static uint16_t telem_task_rate(void (*func)(void)) {
+    for (int i = 0; i < SCHED_MAX_TASKS; i ++) {
+        if (sched.task[i].func == func) {
+            return sched.task[i].rate;
+        }
+    }
+    return 0;
+}
+
+static uint8_t telem_page0(uint16_t *v) {
+    uint32_t msec = timer_get_msec();
+    LED_STATS led;
+    led_get_stats(&led);
+    v[TELEM_UPTIME_LO] = msec;
+    v[TELEM_UPTIME_HI] = msec >> 16;
+    v[TELEM_LOOP_RATE] = sched.loop_rate;
+    v[TELEM_SCAN_RATE] = telem_task_rate(key_scan);
+    v[TELEM_DUTY] = idle.duty;
+    v[TELEM_LED_PUSHED] = led.pushed;
+    v[TELEM_LED_SKIPPED] = led.skipped;
+    v[TELEM_RAM_FREE_MIN] = ram.free_min;
+    v[TELEM_STACK_MAX] = ram.stack_max;
+#if defined(ISR_PROFILE)
+    ISRPROF_STATS isr;
+    isrprof_get(ISRPROF_LED, &isr);
+    v[TELEM_ISR_RX_WAIT] = isrprof_rx_wait_max();
+    v[TELEM_ISR_LED_MAX] = isr.max;
+#else
+    v[TELEM_ISR_RX_WAIT] = 0;
+    v[TELEM_ISR_LED_MAX] = 0;
+#endif
+    v[TELEM_BOOT_FAILS] = boot.fails;
+    v[TELEM_BOOT_USEC] = (boot.ready_usec > 0xffff) ? 0xffff : boot.ready_usec;
+    return TELEM_PAGE0_SIZE;
+}
+
+static uint8_t telem_page1(uint16_t *v) {
+    UART_STATS uart;
+    uart_get_stats(&uart);
+    v[TELEM_RX_BYTES] = uart.rx_bytes;
+    v[TELEM_TX_BYTES] = uart.tx_bytes;
+    v[TELEM_RX_PARITY] = uart.rx_parity_error;
+    v[TELEM_RX_FRAMING] = uart.rx_framing_error;
+    v[TELEM_RX_OVERRUN] = uart.rx_overrun_error;
+    v[TELEM_RX_OVERFLOW] = uart.rx_overflow_error;
+    v[TELEM_RX_DEPTH_MAX] = uart.rx_depth_max;
+    v[TELEM_TX_DEPTH_MAX] = uart.tx_depth_max;
+    v[TELEM_MERGE_DEPTH_MAX] = merge.depth_max;
+    v[TELEM_MERGE_DROPPED] = merge.dropped;
+    v[TELEM_MERGE_LATENCY_MAX] = merge.latency_max;
+    v[TELEM_LOG_DEPTH_MAX] = log_ctrl.depth_max;
+    return TELEM_PAGE1_SIZE;
+}
+
+//-----------------------------------------------------------------------------
+
+// return non-zero if a page can be sent
+int telem_pending(void) {
+    if (telem.page == TELEM_IDLE) {
+        return 0;
+    }
+    return merge_tx_ready();
+}
+
+// send the pages that fit
+void telem_run(void) {
+    while (telem_pending()) {
+        uint16_t v[TELEM_PAGE_MAX];
+        uint8_t n = (telem.page == 0) ? telem_page0(v) : telem_page1(v);
+        uart_tx(SYSEX_START);
+        uart_tx(TRACE_ID);
+        uart_tx(TELEM_CMD);
+        uart_tx(telem.page);
+        uart_tx(n);
+        for (uint8_t i = 0; i < n; i ++) {
+            uart_tx(v[i] & 0x7f);
+            uart_tx((v[i] >> 7) & 0x7f);
+            uart_tx(v[i] >> 14);
+        }
+        uart_tx(SYSEX_END);
+        telem.page ++;
+        if (telem.page == TELEM_PAGES) {
+            telem.page = TELEM_IDLE;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// midi sysex callback
+
+void telem_sysex(uint8_t c) {
+    if (c == SYSEX_START) {
+        telem.rx_state = TELEM_RX_MFR;
+        return;
+    }
+    if ((c == SYSEX_END) || (c == SYSEX_ABORT)) {
+        if ((c == SYSEX_END) && (telem.rx_state == TELEM_RX_END) && (telem.page == TELEM_IDLE)) {
+            telem.page = 0;
+        }
+        telem.rx_state = TELEM_RX_IDLE;
+        return;
+    }
+    switch (telem.rx_state) {
+        case TELEM_RX_MFR: {
+            telem.rx_state = (c == TRACE_ID) ? TELEM_RX_CMD : TELEM_RX_IDLE;
+            break;
+        }
+        case TELEM_RX_CMD: {
+            telem.rx_state = (c == TELEM_CMD) ? TELEM_RX_END : TELEM_RX_IDLE;
+            break;
+        }
+        default: {
+            // no arguments
+            telem.rx_state = TELEM_RX_IDLE;
+            break;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+int telem_init(void) {
+    memset(&telem, 0, sizeof(telem));
+    telem.page = TELEM_IDLE;
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,63 @@
+//-----------------------------------------------------------------------------
+/*
+
+Health Telemetry
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef TELEM_H
+#define TELEM_H
+
+//-----------------------------------------------------------------------------
+
+// sysex request: F0 7D 30 F7
+// reply, a message per page: F0 7D 30 <page> <n> (<value> x 3 bytes) x n F7
+#define TELEM_CMD       0x30
+
+// page 0: system
+#define TELEM_UPTIME_LO     0   // msec since reset, low 16 bits
+#define TELEM_UPTIME_HI     1   // and high 16 bits
+#define TELEM_LOOP_RATE     2   // scheduler passes in the last second
+#define TELEM_SCAN_RATE     3   // key scans in the last second
+#define TELEM_DUTY          4   // busy time in the last second (0.1%)
+#define TELEM_LED_PUSHED    5   // led frames sent (wraps)
+#define TELEM_LED_SKIPPED   6   // led frames without changes (wraps)
+#define TELEM_RAM_FREE_MIN  7   // bytes, free ram low water mark
+#define TELEM_STACK_MAX     8   // bytes, stack high water mark
+#define TELEM_ISR_RX_WAIT   9   // 0.5 usec ticks, 0 without ISR_PROFILE
+#define TELEM_ISR_LED_MAX   10  // 0.5 usec ticks, 0 without ISR_PROFILE
+#define TELEM_BOOT_FAILS    11  // init functions that failed
+#define TELEM_BOOT_USEC     12  // timer start to the application running (saturates)
+#define TELEM_PAGE0_SIZE    13
+
+// page 1: midi and queues
+#define TELEM_RX_BYTES      0   // wraps
+#define TELEM_TX_BYTES      1   // wraps
+#define TELEM_RX_PARITY     2
+#define TELEM_RX_FRAMING    3
+#define TELEM_RX_OVERRUN    4
+#define TELEM_RX_OVERFLOW   5   // rx buffer full
+#define TELEM_RX_DEPTH_MAX  6
+#define TELEM_TX_DEPTH_MAX  7
+#define TELEM_MERGE_DEPTH_MAX 8
+#define TELEM_MERGE_DROPPED 9
+#define TELEM_MERGE_LATENCY_MAX 10 // usec
+#define TELEM_LOG_DEPTH_MAX 11
+#define TELEM_PAGE1_SIZE    12
+
+#define TELEM_PAGES         2
+
+//-----------------------------------------------------------------------------
+// API functions
+
+int telem_init(void);
+void telem_sysex(uint8_t c);
+int telem_pending(void);
+void telem_run(void);
+
+//-----------------------------------------------------------------------------
+
+#endif // TELEM_H
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,179 @@
+//-----------------------------------------------------------------------------
+/*
+
+MIDI Clock Tempo Tracker
+
+Follow the midi clock (24 per beat) from an external sequencer so effects
+can lock to it. tempo_rx() is the midi realtime callback.
+
+Each clock is timestamped when it is parsed, which adds the scheduling
+latency of the midi task to the uart jitter. Two filters clean this up:
+
+- The clock period is a moving average: period += (measured - period) / 8.
+  Periods less than half or more than twice the average are ignored, two
+  in a row reset the average to the new period (a tempo change, or the
+  clock resuming after a gap).
+
+- The time of the last clock is a phase locked estimate: the predicted
+  time (last + period) corrected by a quarter of the error.
+
+Start resets the song position and the next clock is the first tick of
+bar 0. Continue resumes from the current position, stop holds it. The
+clock keeps being tracked while stopped, as most sequencers keep sending
+it.
+
+The position (bar, beat, tick) is advanced per clock. tempo_phase() and
+tempo_bpm() do the only divisions, when they are asked for.
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+
+#include "timer.h"
+#include "midi.h"
+#include "tempo.h"
+
+//-----------------------------------------------------------------------------
+
+#define TEMPO_FILTER_SHIFT  3   // period average over ~8 clocks
+#define TEMPO_PLL_SHIFT     2   // phase correction gain 1/4
+#define TEMPO_LOCK_CLOCKS   4   // clocks before the tempo is trusted
+#define TEMPO_LOST_PERIODS  4   // unlocked after this many missing clocks
+
+//-----------------------------------------------------------------------------
+
+TEMPO_CTRL tempo;
+
+//-----------------------------------------------------------------------------
+
+static void tempo_clock(uint32_t now) {
+    uint32_t p = tempo.period >> 4;
+    uint32_t m = now - tempo.tick_usec;
+
+    if (tempo.valid == 0) {
+        // first clock: no period yet
+        tempo.tick_usec = now;
+        tempo.valid = 1;
+        return;
+    }
+    if ((tempo.valid > 1) && ((m <= (p >> 1)) || (m >= (p << 1)))) {
+        if (++ tempo.outliers < 2) {
+            // ignore a single odd period, but keep time
+            tempo.tick_usec = now;
+            return;
+        }
+        // two in a row: restart the average
+        tempo.valid = 1;
+    }
+    tempo.outliers = 0;
+
+    if (tempo.valid == 1) {
+        tempo.period = m << 4;
+        tempo.tick_usec = now;
+    } else {
+        tempo.period += (int32_t)((m << 4) - tempo.period) >> TEMPO_FILTER_SHIFT;
+        uint32_t predicted = tempo.tick_usec + (tempo.period >> 4);
+        tempo.tick_usec = predicted + ((int32_t)(now - predicted) >> TEMPO_PLL_SHIFT);
+    }
+    if (tempo.valid < 255) {
+        tempo.valid ++;
+    }
+}
+
+static void tempo_advance(void) {
+    if (tempo.started) {
+        // first clock after start
+        tempo.started = 0;
+        return;
+    }
+    if (++ tempo.tick < TEMPO_PPQN) {
+        return;
+    }
+    tempo.tick = 0;
+    if (++ tempo.beat < tempo.beats_per_bar) {
+        return;
+    }
+    tempo.beat = 0;
+    tempo.bar ++;
+}
+
+// midi realtime callback
+void tempo_rx(uint8_t c) {
+    switch (c) {
+        case MIDI_CLOCK: {
+            tempo_clock(timer_get_usec());
+            if (tempo.running) {
+                tempo_advance();
+            }
+            break;
+        }
+        case MIDI_START: {
+            tempo.bar = 0;
+            tempo.beat = 0;
+            tempo.tick = 0;
+            tempo.started = 1;
+            tempo.running = 1;
+            break;
+        }
+        case MIDI_CONTINUE: {
+            tempo.running = 1;
+            break;
+        }
+        case MIDI_STOP: {
+            tempo.running = 0;
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+// return non-zero if the clock is arriving and the tempo is known
+int tempo_locked(void) {
+    if (tempo.valid < TEMPO_LOCK_CLOCKS) {
+        return 0;
+    }
+    // the filtered clock time can be just ahead of now
+    int32_t age = (int32_t)(timer_get_usec() - tempo.tick_usec);
+    return age < (int32_t)((tempo.period >> 4) * TEMPO_LOST_PERIODS);
+}
+
+// return the tempo in 0.1 bpm units, 0 if not locked
+uint16_t tempo_bpm(void) {
+    if (!tempo_locked()) {
+        return 0;
+    }
+    // 60e6 usec * 10 / (24 clocks * period usec), period is * 16
+    return (uint16_t)(400000000UL / tempo.period);
+}
+
+// return the position within the beat, 0..255
+uint8_t tempo_phase(void) {
+    uint32_t p = tempo.period >> 4;
+    int32_t dt = (int32_t)(timer_get_usec() - tempo.tick_usec);
+    uint16_t frac = 0;
+    if ((dt > 0) && (p != 0)) {
+        // fraction of a clock period, held at the next clock
+        frac = ((uint32_t)dt << 8) / p;
+        if (frac > 255) {
+            frac = 255;
+        }
+    }
+    // (tick * 256 + frac) / 24
+    return (uint8_t)(((uint32_t)((tempo.tick << 8) + frac) * 2731) >> 16);
+}
+
+//-----------------------------------------------------------------------------
+
+int tempo_init(void) {
+    memset(&tempo, 0, sizeof(tempo));
+    tempo.beats_per_bar = TEMPO_BEATS_PER_BAR;
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,49 @@
+//-----------------------------------------------------------------------------
+/*
+
+MIDI Clock Tempo Tracker
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef TEMPO_H
+#define TEMPO_H
+
+//-----------------------------------------------------------------------------
+
+#define TEMPO_PPQN 24           // midi clocks per beat
+#define TEMPO_BEATS_PER_BAR 4   // default
+
+//-----------------------------------------------------------------------------
+
+typedef struct tempo_control {
+
+    uint32_t period;        // filtered clock period, usec * 16
+    uint32_t tick_usec;     // filtered time of the last clock
+    uint16_t bar;           // bars since start
+    uint8_t beat;           // beat within the bar
+    uint8_t tick;           // clock within the beat
+    uint8_t beats_per_bar;
+    uint8_t running;        // between start/continue and stop
+    uint8_t started;        // start seen, the next clock is tick 0
+    uint8_t valid;          // clocks seen since the period was reset
+    uint8_t outliers;       // consecutive out of range clock periods
+
+} TEMPO_CTRL;
+
+extern TEMPO_CTRL tempo;
+
+//-----------------------------------------------------------------------------
+// API functions
+
+int tempo_init(void);
+void tempo_rx(uint8_t c);
+int tempo_locked(void);
+uint16_t tempo_bpm(void);
+uint8_t tempo_phase(void);
+
+//-----------------------------------------------------------------------------
+
+#endif // TEMPO_H
+
+//-----------------------------------------------------------------------------
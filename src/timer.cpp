@@ -3,40 +3,139 @@
 
 Timer Functions
 
-Provide a simple timer using the 16-bit timer 1 of the ATmega328P.
+Provide a simple timer using the 16-bit timer 1 of the ATmega328P (through
+the hal tick counter).
+
+Timer 1 is clocked at F_CPU / 8 = 2 MHz, so a tick is exactly 0.5 us and the
+counter overflows every 65536 ticks = 32768 us. The microsecond time is then
+just (overflows << 15) | (ticks >> 1) - no approximations and no divides.
+
+The millisecond time is kept separately by the overflow isr as a whole
+millisecond count plus a microsecond remainder (32768 us = 32 ms + 768 us),
+so it stays exact and wraps at 2^32 ms rather than 2^32 us.
+
+Reading the time races with the overflow: if TCNT1 has wrapped but the
+overflow isr has not run yet (we are in an atomic block, or the isr is
+pending) the count would jump backwards. A pending TOV1 with a small TCNT1
+value is counted as an extra overflow.
 
 */
 //-----------------------------------------------------------------------------
 
 #include <stdint.h>
-#include <avr/io.h>
-#include <util/atomic.h>
 
+#include "hal.h"
 #include "timer.h"
 
 //-----------------------------------------------------------------------------
 
-static uint32_t timer_ovf_count;
+#define USEC_PER_OVF 32768UL
+
+static volatile uint32_t timer_ovf_count;
+static volatile uint32_t timer_msec;
+static volatile uint16_t timer_msec_frac; // 0..999 us
 
 void timer_ovf_isr(void)
 {
     timer_ovf_count ++;
+    timer_msec += USEC_PER_OVF / 1000;
+    timer_msec_frac += USEC_PER_OVF % 1000;
+    if (timer_msec_frac >= 1000) {
+        timer_msec_frac -= 1000;
+        timer_msec ++;
+    }
 }
 
 //-----------------------------------------------------------------------------
-// return the time since boot in milliseconds
+// return the time since boot in microseconds (wraps every 71.6 minutes)
 
-uint32_t timer_get_msec(void)
+uint32_t timer_get_usec(void)
+{
+    uint32_t ovf;
+    uint16_t tcnt;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        ovf = timer_ovf_count;
+        tcnt = hal_tick_count();
+        if (hal_tick_ovf_pending() && (tcnt < 0x8000)) {
+            // overflowed, but the isr hasn't run yet
+            ovf ++;
+        }
+    }
+    return (ovf << 15) | (tcnt >> 1);
+}
+
+//-----------------------------------------------------------------------------
+// Return the raw 0.5 us tick count and the low 8 bits of the overflow
+// count (together they wrap every 8.4 seconds), a timestamp without the
+// 32 bit shifts. Call with interrupts disabled.
+
+uint16_t timer_get_ticks(uint8_t *ovf)
 {
-    // ticks_per_millisecond = F_CPU /(1000 * TIMER_DIV) = 15.625
-    // Approximate this as 16 to create a millsecond count using bit shifts.
+    uint16_t tcnt = hal_tick_count();
+    uint8_t n = timer_ovf_count;
+    if (hal_tick_ovf_pending() && (tcnt < 0x8000)) {
+        // overflowed, but the isr hasn't run yet
+        n ++;
+    }
+    *ovf = n;
+    return tcnt;
+}
+
+//-----------------------------------------------------------------------------
+// return the time since boot in milliseconds (wraps every 49.7 days)
 
+uint32_t timer_get_msec(void)
+{
     uint32_t msec;
+    uint16_t usec;
     ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
-        msec = timer_ovf_count << 12;
-        msec |= TCNT1 >> 4;
+        msec = timer_msec;
+        usec = timer_msec_frac;
+        uint16_t tcnt = hal_tick_count();
+        if (hal_tick_ovf_pending() && (tcnt < 0x8000)) {
+            // overflowed, but the isr hasn't run yet
+            msec += USEC_PER_OVF / 1000;
+            usec += USEC_PER_OVF % 1000;
+        }
+        usec += tcnt >> 1;
     }
-    return msec;
+    // usec < 1000 + 768 + 32768, so this is a 16 bit divide
+    return msec + (usec / 1000);
+}
+
+//-----------------------------------------------------------------------------
+// Set a one-shot compare match interrupt for a millisecond time. This only
+// exists to wake the cpu from sleep, the isr does nothing else. Alarms that
+// are beyond the current overflow period are not set, the overflow
+// interrupt will wake the cpu first. Call with interrupts disabled.
+
+void timer_set_alarm(uint32_t msec)
+{
+    uint16_t tcnt = hal_tick_count();
+    if (hal_tick_ovf_pending()) {
+        // the overflow isr will wake us
+        return;
+    }
+    int32_t dt = (int32_t)(msec - timer_msec);
+    if (dt > (int32_t)(USEC_PER_OVF / 1000) + 1) {
+        return;
+    }
+    // microseconds until the alarm
+    dt = (dt * 1000) - timer_msec_frac - (tcnt >> 1);
+    if (dt < 1) {
+        dt = 1;
+    }
+    // ticks until the alarm
+    dt <<= 1;
+    if (dt >= (int32_t)(0x10000UL - tcnt)) {
+        return;
+    }
+    hal_tick_alarm(tcnt + (uint16_t)dt);
+}
+
+void timer_alarm_isr(void)
+{
+    hal_tick_alarm_off();
 }
 
 //-----------------------------------------------------------------------------
@@ -45,16 +144,19 @@ uint32_t timer_get_msec(void)
 void timer_delay_msec(int n)
 {
     uint32_t timeout = timer_get_msec() + n;
-    while(timer_get_msec() < timeout);
+    while (!timer_after(timer_get_msec(), timeout)) {
+        hal_spin();
+    }
 }
 
 void timer_delay_msec_poll(int n, void (*poll)(void))
 {
     uint32_t timeout = timer_get_msec() + n;
-    while(timer_get_msec() < timeout) {
+    while (!timer_after(timer_get_msec(), timeout)) {
         if (poll) {
             poll();
         }
+        hal_spin();
     }
 }
 
@@ -63,7 +165,9 @@ void timer_delay_msec_poll(int n, void (*poll)(void))
 
 void timer_delay_until(uint32_t time)
 {
-    while(timer_get_msec() < time);
+    while (!timer_after(timer_get_msec(), time)) {
+        hal_spin();
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -71,19 +175,14 @@ void timer_delay_until(uint32_t time)
 int timer_init(void)
 {
     timer_ovf_count = 0;
+    timer_msec = 0;
+    timer_msec_frac = 0;
 
     // using the 16 bit timer 1 for a tick counter
-    // clock the counter at F_CPU / 1024 = 15625 Hz
-    // increment an overflow counter every 2^16 / 15625 = 4.2 seconds
-
-    TCCR1A = 0;
-    TCCR1B = DIVIDE_BY_1024;
-    TCCR1C = 0;
-    OCR1A = 0;
-    OCR1B = 0;
-    ICR1 = 0;
-    TIMSK1 = (1 << TOIE1);
-    TIFR1 = (1 << TOV1);
+    // clock the counter at F_CPU / 8 = 2 MHz (0.5 us per tick)
+    // increment an overflow counter every 2^16 / 2 MHz = 32.768 ms
+
+    hal_tick_init();
     return 0;
 }
 
@@ -96,6 +195,11 @@ unsigned long millis(void)
     return timer_get_msec();
 }
 
+unsigned long micros(void)
+{
+    return timer_get_usec();
+}
+
 void delay(unsigned long ms)
 {
     timer_delay_msec((int)ms);
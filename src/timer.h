@@ -22,11 +22,22 @@ Timer Functions
 // API functions
 
 void timer_ovf_isr(void);
+void timer_alarm_isr(void);
 int timer_init(void);
 void timer_delay_msec(int n);
 void timer_delay_msec_poll(int n, void (*poll)(void));
 void timer_delay_until(uint32_t time);
 uint32_t timer_get_msec(void);
+uint32_t timer_get_usec(void);
+uint16_t timer_get_ticks(uint8_t *ovf);
+void timer_set_alarm(uint32_t msec);
+
+//-----------------------------------------------------------------------------
+// wrap safe time comparison: non-zero if time a is at or after time b
+
+static inline int timer_after(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) >= 0;
+}
 
 //-----------------------------------------------------------------------------
 
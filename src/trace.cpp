@@ -0,0 +1,276 @@
+//-----------------------------------------------------------------------------
+/*
+
+Event Trace
+
+A ring of fixed size records (event id, timestamp, two byte arguments)
+written by the TRACE() calls in the isrs and the main loop. When the ring
+is full the oldest record is overwritten, so it always holds the most
+recent events. tools/tracedump.py turns a dump into a timeline and pairs
+the events into latencies (key to note out, byte in to message parsed,
+frame render and lcd flush times).
+
+A record is 6 bytes: the raw timer 1 count and the low byte of its
+overflow count (0.5 usec steps, wrapping every 8.4 secs), the id and the
+arguments. Taking it is a few loads and stores with interrupts off, no
+32 bit time arithmetic. Events not in the mask cost only the mask test.
+The dump header carries the usec time and the tick count of the same
+moment, so the decoder puts the records on the usec timeline. A record
+more than 8.4 secs older than its dump is placed a multiple of 8.4 secs
+late.
+
+The firmware ring is only TRACE_SIZE (4) records, what fits the stack
+budget (see RAM_STACK in the Makefile). The mask picks the events worth
+keeping, e.g. key down and note out for the key to note latency. A debug
+build can have more with make TRACE_SIZE=16, taking 72 bytes from the
+stack. TRACE_SIZE=0 compiles the ring out, a dump then has no records.
+
+The ring is read out over midi:
+
+F0 7D 20 F7             dump the ring
+F0 7D 21 <lo> <hi> F7   set the event mask (14 bits, bit n is event id n)
+F0 7D 22 F7             empty the ring
+
+The dump is a header message, a message per record (oldest first) and an
+end message, with all values in 7 bit groups, least significant first.
+The messages (at most 19 bytes) go out whole from trace_run() and only
+when the uart is nearly empty, like the merged input. Events during a dump are
+not recorded (the ring is being read) but are counted, the count goes out
+in the header of the next dump. The ring is empty after a dump, so
+successive dumps give a continuous trace if they are frequent enough.
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+
+#include "hal.h"
+#include "common.h"
+#include "uart.h"
+#include "timer.h"
+#include "midi.h"
+#include "merge.h"
+#include "trace.h"
+
+//-----------------------------------------------------------------------------
+
+#if (TRACE_SIZE & (TRACE_SIZE - 1)) || (TRACE_SIZE > 64)
+#error "TRACE_SIZE must be a power of 2, up to 64"
+#endif
+
+enum {
+    TRACE_RX_IDLE,      // not our message
+    TRACE_RX_MFR,       // expecting the manufacturer id
+    TRACE_RX_CMD,       // expecting the command
+    TRACE_RX_DATA,      // command arguments
+};
+
+enum {
+    TRACE_DUMP_IDLE,
+    TRACE_DUMP_SEND_HEADER,
+    TRACE_DUMP_SEND_RECORDS,
+    TRACE_DUMP_SEND_END,
+};
+
+//-----------------------------------------------------------------------------
+
+TRACE_CTRL trace;
+
+//-----------------------------------------------------------------------------
+
+// record an event
+void trace_event(uint8_t id, uint8_t a, uint8_t b) {
+#if TRACE_SIZE
+    if ((trace.mask & (1U << id)) == 0) {
+        return;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        if (trace.dump != TRACE_DUMP_IDLE) {
+            trace.missed ++;
+        } else {
+            TRACE_REC *r = &trace.ring[trace.wr];
+            r->ticks = timer_get_ticks(&r->ovf);
+            r->id = id;
+            r->a = a;
+            r->b = b;
+            trace.wr = inc_mod(trace.wr, (TRACE_SIZE - 1));
+            if (trace.count < TRACE_SIZE) {
+                trace.count ++;
+            }
+        }
+    }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// dump
+
+// send n 7 bit groups of x, least significant first
+static void trace_tx7(uint32_t x, uint8_t n) {
+    while (n --) {
+        uart_tx(x & 0x7f);
+        x >>= 7;
+    }
+}
+
+static void trace_tx_start(uint8_t type) {
+    uart_tx(SYSEX_START);
+    uart_tx(TRACE_ID);
+    uart_tx(TRACE_CMD_DUMP);
+    uart_tx(type);
+}
+
+// return non-zero if a dump message can be sent
+int trace_pending(void) {
+    if (trace.dump == TRACE_DUMP_IDLE) {
+        return 0;
+    }
+    return merge_tx_ready();
+}
+
+// send the dump messages that fit
+void trace_run(void) {
+    while (trace_pending()) {
+        switch (trace.dump) {
+            case TRACE_DUMP_SEND_HEADER: {
+                uint16_t missed;
+                uint32_t usec;
+                uint16_t ticks;
+                uint8_t ovf;
+                ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                    missed = trace.missed;
+                    trace.missed = 0;
+                    ticks = timer_get_ticks(&ovf);
+                    usec = timer_get_usec();
+                }
+                trace_tx_start(TRACE_DUMP_HEADER);
+                uart_tx(TRACE_VERSION);
+                uart_tx(trace.count & 0x7f);
+                uart_tx(TRACE_SIZE & 0x7f);
+                trace_tx7(missed, 3);
+                trace_tx7(usec, 5);
+                trace_tx7(((uint32_t)ovf << 16) | ticks, 4);
+                uart_tx(SYSEX_END);
+                trace.dump_posn = 0;
+                trace.dump = TRACE_DUMP_SEND_RECORDS;
+                break;
+            }
+            case TRACE_DUMP_SEND_RECORDS: {
+#if TRACE_SIZE
+                if (trace.dump_posn >= trace.count) {
+                    trace.dump = TRACE_DUMP_SEND_END;
+                    break;
+                }
+                uint8_t i = (trace.wr - trace.count + trace.dump_posn) & (TRACE_SIZE - 1);
+                const TRACE_REC *r = &trace.ring[i];
+                trace_tx_start(TRACE_DUMP_RECORD);
+                uart_tx(r->id & 0x7f);
+                trace_tx7(r->a, 2);
+                trace_tx7(r->b, 2);
+                trace_tx7(((uint32_t)r->ovf << 16) | r->ticks, 4);
+                uart_tx(SYSEX_END);
+                trace.dump_posn ++;
+#else
+                trace.dump = TRACE_DUMP_SEND_END;
+#endif
+                break;
+            }
+            case TRACE_DUMP_SEND_END:
+            default: {
+                trace_tx_start(TRACE_DUMP_END);
+                uart_tx(SYSEX_END);
+                ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                    trace.count = 0;
+                    trace.dump = TRACE_DUMP_IDLE;
+                }
+                break;
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// midi sysex callback
+
+static void trace_command(void) {
+    switch (trace.rx_cmd) {
+        case TRACE_CMD_DUMP: {
+            if (trace.dump == TRACE_DUMP_IDLE) {
+                ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                    trace.dump = TRACE_DUMP_SEND_HEADER;
+                }
+            }
+            break;
+        }
+        case TRACE_CMD_MASK: {
+            if (trace.rx_count == 2) {
+                trace.mask = trace.rx_data[0] | (trace.rx_data[1] << 7);
+            }
+            break;
+        }
+        case TRACE_CMD_CLEAR: {
+            if (trace.dump == TRACE_DUMP_IDLE) {
+                ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                    trace.count = 0;
+                    trace.missed = 0;
+                }
+            }
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+void trace_sysex(uint8_t c) {
+    if (c == SYSEX_START) {
+        trace.rx_state = TRACE_RX_MFR;
+        return;
+    }
+    if ((c == SYSEX_END) || (c == SYSEX_ABORT)) {
+        if ((c == SYSEX_END) && (trace.rx_state == TRACE_RX_DATA)) {
+            trace_command();
+        }
+        trace.rx_state = TRACE_RX_IDLE;
+        return;
+    }
+    switch (trace.rx_state) {
+        case TRACE_RX_MFR: {
+            trace.rx_state = (c == TRACE_ID) ? TRACE_RX_CMD : TRACE_RX_IDLE;
+            break;
+        }
+        case TRACE_RX_CMD: {
+            trace.rx_state = TRACE_RX_IDLE;
+            if ((c >= TRACE_CMD_DUMP) && (c <= TRACE_CMD_CLEAR)) {
+                trace.rx_cmd = c;
+                trace.rx_count = 0;
+                trace.rx_state = TRACE_RX_DATA;
+            }
+            break;
+        }
+        case TRACE_RX_DATA: {
+            if (trace.rx_count < sizeof(trace.rx_data)) {
+                trace.rx_data[trace.rx_count] = c;
+            }
+            if (trace.rx_count < 0xff) {
+                trace.rx_count ++;
+            }
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+int trace_init(void) {
+    memset(&trace, 0, sizeof(trace));
+    trace.mask = (1U << TRACE_IDS) - 1;
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
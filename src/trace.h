@@ -0,0 +1,101 @@
+//-----------------------------------------------------------------------------
+/*
+
+Event Trace
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef TRACE_H
+#define TRACE_H
+
+//-----------------------------------------------------------------------------
+
+// records in the ring (a power of 2 up to 64, 6 bytes each), 0 for none.
+// The default is what the RAM_STACK budget leaves room for, a debug build
+// can take more (make TRACE_SIZE=16) at the cost of stack.
+#ifndef TRACE_SIZE
+#define TRACE_SIZE 4
+#endif
+
+#if TRACE_SIZE
+#define TRACE(id, a, b) trace_event(id, a, b)
+#else
+#define TRACE(id, a, b)
+#endif
+
+// event ids (a, b are the record arguments)
+#define TRACE_KEY_DOWN      1   // a = key
+#define TRACE_KEY_UP        2   // a = key
+#define TRACE_UART_RX       3   // status byte received: a = byte, b = rx buffer depth
+#define TRACE_MIDI_RX       4   // message parsed: a = status, b = first data byte
+#define TRACE_MIDI_TX       5   // local note sent: a = status, b = note
+#define TRACE_MIDI_FWD      6   // message forwarded: a = status, b = time queued (64 usecs, 255 = more)
+#define TRACE_FRAME_START   7   // frame task: a = led frame count
+#define TRACE_FRAME_END     8   // b = non-zero if the leds changed
+#define TRACE_LED_PUSH      9   // led isr: a = led frame count, b = modules sent
+#define TRACE_LCD_START     10
+#define TRACE_LCD_END       11  // b = non-zero if there is more to flush
+#define TRACE_MARK          12  // for debugging
+#define TRACE_IDS           13
+
+#define TRACE_ID            0x7d    // non-commercial manufacturer id
+
+// sysex commands: F0 7D <cmd> ... F7
+// (stream.h has 0x01..0x15, telem.h has 0x30)
+#define TRACE_CMD_DUMP      0x20    // reply with the ring, oldest first
+#define TRACE_CMD_MASK      0x21    // <lo7> <hi7>: bit per event id to record
+#define TRACE_CMD_CLEAR     0x22    // empty the ring
+
+// dump replies: F0 7D 20 <type> ... F7
+#define TRACE_DUMP_HEADER   0       // version, count, size, missed (3 x 7), usec now (5 x 7), ticks now (4 x 7)
+#define TRACE_DUMP_RECORD   1       // id, a (2 x 7), b (2 x 7), ticks (4 x 7)
+#define TRACE_DUMP_END      2
+#define TRACE_VERSION       2
+
+//-----------------------------------------------------------------------------
+
+typedef struct trace_record {
+
+    uint16_t ticks;         // timer 1 count (0.5 usec)
+    uint8_t ovf;            // timer 1 overflows, low 8 bits
+    uint8_t id;
+    uint8_t a;
+    uint8_t b;
+
+} TRACE_REC;
+
+typedef struct trace_control {
+
+#if TRACE_SIZE
+    TRACE_REC ring[TRACE_SIZE];
+#endif
+    uint8_t wr;             // next record to write
+    uint8_t count;          // records in the ring
+    uint16_t mask;          // bit per event id to record
+    uint16_t missed;        // events dropped during a dump
+    uint8_t dump;           // dump state, 0 = idle
+    uint8_t dump_posn;      // next record to send
+    uint8_t rx_state;       // sysex command parser
+    uint8_t rx_cmd;
+    uint8_t rx_data[2];
+    uint8_t rx_count;
+
+} TRACE_CTRL;
+
+extern TRACE_CTRL trace;
+
+//-----------------------------------------------------------------------------
+// API functions
+
+int trace_init(void);
+void trace_event(uint8_t id, uint8_t a, uint8_t b);
+void trace_sysex(uint8_t c);
+int trace_pending(void);
+void trace_run(void);
+
+//-----------------------------------------------------------------------------
+
+#endif // TRACE_H
+
+//-----------------------------------------------------------------------------
@@ -8,11 +8,11 @@ UART Driver
 
 #include <stdio.h>
 #include <string.h>
-#include <avr/io.h>
-#include <avr/pgmspace.h>
-#include <avr/interrupt.h>
+#include <stdint.h>
 
+#include "hal.h"
 #include "common.h"
+#include "trace.h"
 #include "uart.h"
 
 //-----------------------------------------------------------------------------
@@ -35,13 +35,7 @@ static UART_STATS stats;
 
 int uart_init(void)
 {
-    UBRR0L = (F_CPU / (8UL * UART_BAUD)) - 1;
-    UBRR0H = 0;
-    // double speed
-    UCSR0A = _BV(U2X0);
-    // 8 data, no parity, 1 stop
-    UCSR0C = (3 << 1);
-    UCSR0B = _BV(TXEN0)|_BV(RXEN0)|_BV(RXCIE0);
+    hal_uart_init(UART_BAUD);
     return 0;
 }
 
@@ -54,24 +48,24 @@ void uart_rx_isr(void)
 
     stats.rx_ints ++;
 
-    while (((status = UCSR0A) & _BV(RXC0)) != 0)
+    while (((status = hal_uart_rx_status()) & HAL_UART_RX_READY) != 0)
     {
-        uint8_t c = UDR0;
+        uint8_t c = hal_uart_rx_byte();
 
         // Check errors
-        if (status & _BV(UPE0))
+        if (status & HAL_UART_PARITY)
         {
             stats.rx_parity_error ++;
             break;
         }
 
-        if (status & _BV(FE0))
+        if (status & HAL_UART_FRAMING)
         {
             stats.rx_framing_error ++;
             break;
         }
 
-        if (status & _BV(DOR0))
+        if (status & HAL_UART_OVERRUN)
         {
             stats.rx_overrun_error ++;
             break;
@@ -83,6 +77,16 @@ void uart_rx_isr(void)
             rx_buffer[rx_wr] = c;
             rx_wr = inc_mod(rx_wr, (UART_RX_BUFSIZE - 1));
             stats.rx_bytes ++;
+            uint8_t depth = (rx_wr - rx_rd) & (UART_RX_BUFSIZE - 1);
+            if (depth > stats.rx_depth_max)
+            {
+                stats.rx_depth_max = depth;
+            }
+            // status bytes, but not the realtime clock
+            if ((c & 0x80) && (c < 0xf8))
+            {
+                TRACE(TRACE_UART_RX, c, depth);
+            }
         }
         else
         {
@@ -101,13 +105,13 @@ void uart_tx_isr(void)
     if (tx_rd != tx_wr)
     {
         stats.tx_bytes ++;
-        UDR0 = tx_buffer[tx_rd];
+        hal_uart_tx_byte(tx_buffer[tx_rd]);
         tx_rd = inc_mod(tx_rd, (UART_TX_BUFSIZE - 1));
     }
     else
     {
         // No more tx data, disable the tx interrupt.
-        UCSR0B &= (uint8_t)~_BV(UDRIE0);
+        hal_uart_tx_irq(0);
     }
 }
 
@@ -119,12 +123,14 @@ uint8_t uart_rx(void)
     uint8_t c;
 
     // Wait for a character in the Rx buffer.
-    while (rx_rd == rx_wr);
+    while (rx_rd == rx_wr) {
+        hal_spin();
+    }
 
-    cli();
+    hal_irq_disable();
     c = rx_buffer[rx_rd];
     rx_rd = inc_mod(rx_rd, (UART_RX_BUFSIZE - 1));
-    sei();
+    hal_irq_enable();
 
     return c;
 }
@@ -135,20 +141,46 @@ uint8_t uart_rx(void)
 void uart_tx(uint8_t c)
 {
     // Wait for a some space in the Tx buffer.
-    while (inc_mod(tx_wr, (UART_TX_BUFSIZE - 1)) == tx_rd);
+    while (inc_mod(tx_wr, (UART_TX_BUFSIZE - 1)) == tx_rd) {
+        hal_spin();
+    }
 
-    cli();
+    hal_irq_disable();
 
     if (tx_wr == tx_rd)
     {
         // Single byte in buffer, turn on tx interrupts.
-        UCSR0B |= (uint8_t)_BV(UDRIE0);
+        hal_uart_tx_irq(1);
     }
 
     // Put the character into the Tx buffer.
     tx_buffer[tx_wr] = c;
     tx_wr = inc_mod(tx_wr, (UART_TX_BUFSIZE - 1));
-    sei();
+    uint8_t depth = (tx_wr - tx_rd) & (UART_TX_BUFSIZE - 1);
+    if (depth > stats.tx_depth_max)
+    {
+        stats.tx_depth_max = depth;
+    }
+    hal_irq_enable();
+}
+
+//-----------------------------------------------------------------------------
+// Transmit a character ahead of anything in the Tx buffer.
+// For midi realtime bytes, which may be sent between any two bytes.
+
+void uart_tx_urgent(uint8_t c)
+{
+    // Wait for a some space in the Tx buffer.
+    while (inc_mod(tx_wr, (UART_TX_BUFSIZE - 1)) == tx_rd) {
+        hal_spin();
+    }
+
+    hal_irq_disable();
+    // Put the character at the head of the Tx buffer.
+    tx_rd = (tx_rd - 1) & (UART_TX_BUFSIZE - 1);
+    tx_buffer[tx_rd] = c;
+    hal_uart_tx_irq(1);
+    hal_irq_enable();
 }
 
 //-----------------------------------------------------------------------------
@@ -180,4 +212,26 @@ int uart_test_tx(void)
     return (tx_rd == tx_wr) ? 0 : 1;
 }
 
+// Return the free space in the Tx buffer
+int uart_tx_space(void)
+{
+    return (UART_TX_BUFSIZE - 1) - uart_tx_depth();
+}
+
+// Return the bytes waiting in the Tx buffer
+int uart_tx_depth(void)
+{
+    return (tx_wr - tx_rd) & (UART_TX_BUFSIZE - 1);
+}
+
+//-----------------------------------------------------------------------------
+// Copy the statistics
+
+void uart_get_stats(UART_STATS *s)
+{
+    hal_irq_disable();
+    *s = stats;
+    hal_irq_enable();
+}
+
 //-----------------------------------------------------------------------------
@@ -26,6 +26,8 @@ typedef struct
     uint16_t rx_overflow_error;
     uint16_t tx_ints;
     uint16_t tx_bytes;
+    uint16_t rx_depth_max;  // buffer high water marks
+    uint16_t tx_depth_max;
 
 } UART_STATS;
 
@@ -37,9 +39,13 @@ void uart_tx_isr(void);
 // API
 int uart_init(void);
 void uart_tx(uint8_t c);
+void uart_tx_urgent(uint8_t c);
+int uart_tx_space(void);
+int uart_tx_depth(void);
 uint8_t uart_rx(void);
 int uart_test_rx(void);
 int uart_test_tx(void);
+void uart_get_stats(UART_STATS *s);
 
 int uart_putc(char c, FILE *stream);
 int uart_getc(FILE *stream);
@@ -0,0 +1,130 @@
+//-----------------------------------------------------------------------------
+/*
+
+Software Timer Wheel
+
+A hashed timer wheel for "do X in N ms" without a blocking delay.
+
+The wheel has WHEEL_SLOTS slots, each a list of caller owned timers. A
+slot is a single pointer and each timer points back at the pointer to it,
+so a timer is unlinked without a two pointer list head per slot. A timer
+due in n ticks goes in slot (now + n) mod WHEEL_SLOTS with a count of the
+whole turns it still has to wait, so adding and cancelling are O(1).
+wheel_run() advances the wheel by the elapsed ticks of the timer 1 based
+millisecond clock and runs the expiry callbacks. It is called from the
+main loop (as a scheduler task), so the callbacks run in normal context
+and may re-arm or cancel any timer.
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+
+#include "timer.h"
+#include "wheel.h"
+
+//-----------------------------------------------------------------------------
+
+static struct wheel_control {
+    WHEEL_LINK *slot[WHEEL_SLOTS];
+    uint8_t cur;        // slot for the current tick
+    uint32_t next_tick; // msec time of the next tick
+} wheel;
+
+//-----------------------------------------------------------------------------
+// list operations
+
+static void link_insert(WHEEL_LINK **head, WHEEL_LINK *l) {
+    l->next = *head;
+    if (l->next) {
+        l->next->pprev = &l->next;
+    }
+    l->pprev = head;
+    *head = l;
+}
+
+static void link_remove(WHEEL_LINK *l) {
+    *l->pprev = l->next;
+    if (l->next) {
+        l->next->pprev = l->pprev;
+    }
+    l->next = 0;
+    l->pprev = 0;
+}
+
+//-----------------------------------------------------------------------------
+
+// the timer must not be pending (it would be left linked in its slot)
+void wheel_timer_init(WTIMER *t, void (*func)(uint8_t arg), uint8_t arg) {
+    memset(t, 0, sizeof(WTIMER));
+    t->func = func;
+    t->arg = arg;
+}
+
+// (re)arm a timer to expire in msec milliseconds
+void wheel_add(WTIMER *t, uint16_t msec) {
+    if (wheel_pending(t)) {
+        link_remove(&t->link);
+    }
+    if (msec > WHEEL_MAX_MSEC) {
+        msec = WHEEL_MAX_MSEC;
+    }
+    uint16_t ticks = (msec + WHEEL_TICK_MSEC - 1) / WHEEL_TICK_MSEC;
+    if (ticks == 0) {
+        ticks = 1;
+    }
+    t->rounds = (ticks - 1) >> WHEEL_SLOT_BITS;
+    link_insert(&wheel.slot[(wheel.cur + ticks) & (WHEEL_SLOTS - 1)], &t->link);
+}
+
+void wheel_cancel(WTIMER *t) {
+    if (wheel_pending(t)) {
+        link_remove(&t->link);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// advance the wheel to the current time and run any expired timers
+
+void wheel_run(void) {
+    uint32_t now = timer_get_msec();
+
+    while (timer_after(now, wheel.next_tick)) {
+        wheel.next_tick += WHEEL_TICK_MSEC;
+        wheel.cur = (wheel.cur + 1) & (WHEEL_SLOTS - 1);
+
+        // move the expired timers onto a private list
+        WHEEL_LINK *expired = 0;
+        WHEEL_LINK *l = wheel.slot[wheel.cur];
+        while (l) {
+            WHEEL_LINK *next = l->next;
+            WTIMER *t = (WTIMER *)l;
+            if (t->rounds == 0) {
+                link_remove(l);
+                link_insert(&expired, l);
+            } else {
+                t->rounds --;
+            }
+            l = next;
+        }
+
+        // callbacks may add or cancel any timer, including expired ones
+        while (expired) {
+            WTIMER *t = (WTIMER *)expired;
+            link_remove(&t->link);
+            t->func(t->arg);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+int wheel_init(void) {
+    memset(wheel.slot, 0, sizeof(wheel.slot));
+    wheel.cur = 0;
+    wheel.next_tick = timer_get_msec() + WHEEL_TICK_MSEC;
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,58 @@
+//-----------------------------------------------------------------------------
+/*
+
+Software Timer Wheel
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef WHEEL_H
+#define WHEEL_H
+
+//-----------------------------------------------------------------------------
+
+// The tick is the resolution: a timer expires up to one tick late. It is
+// kept at one led frame (16.4 msec) or less so fades and animation steps
+// can be timed to the frame.
+#define WHEEL_SLOT_BITS 3
+#define WHEEL_SLOTS (1 << WHEEL_SLOT_BITS)
+#define WHEEL_TICK_MSEC 16
+
+// longest delay: 256 rounds of the wheel (~32.7 seconds)
+#define WHEEL_MAX_MSEC (256UL * WHEEL_SLOTS * WHEEL_TICK_MSEC - 1)
+
+//-----------------------------------------------------------------------------
+
+typedef struct wheel_link {
+    struct wheel_link *next;
+    struct wheel_link **pprev;  // the pointer to this link, 0 if not linked
+} WHEEL_LINK;
+
+typedef struct wheel_timer {
+
+    WHEEL_LINK link;            // must be first
+    void (*func)(uint8_t arg);  // expiry callback
+    uint8_t arg;
+    uint8_t rounds;             // full turns of the wheel still to wait
+
+} WTIMER;
+
+//-----------------------------------------------------------------------------
+// API functions
+
+int wheel_init(void);
+void wheel_run(void);
+void wheel_timer_init(WTIMER *t, void (*func)(uint8_t arg), uint8_t arg);
+void wheel_add(WTIMER *t, uint16_t msec);
+void wheel_cancel(WTIMER *t);
+
+// non-zero if the timer is armed
+static inline int wheel_pending(WTIMER *t) {
+    return t->link.pprev != 0;
+}
+
+//-----------------------------------------------------------------------------
+
+#endif // WHEEL_H
+
+//-----------------------------------------------------------------------------
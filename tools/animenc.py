@@ -0,0 +1,337 @@
+#!/usr/bin/env python3
+#-----------------------------------------------------------------------------
+"""
+
+Animation Encoder
+
+Encode LED animations into the program memory stream played back by
+src/anim.cpp.
+
+Input animations are PPM images (P3 or P6) with one row per frame and one
+column per led. The built-in demo animations are generated with --demo.
+
+Stream format:
+
+  header   version, leds, frames (16 bits, little endian), msec per frame,
+           palette size (0 = 256)
+  palette  size * (r, g, b)
+  frames   operations covering each led once, op in bits 7..6 and
+           count - 1 in bits 5..0:
+             0 skip  count leds are unchanged from the last frame
+             1 run   count leds of the palette colour in the next byte
+             2 lit   count palette indices follow
+
+Frame 0 is encoded against an all black frame.
+
+Usage:
+
+  animenc.py [-o anim_data.cpp] [--msec N] [--demo NAME] [name=file.ppm ...]
+
+"""
+#-----------------------------------------------------------------------------
+
+import argparse
+import colorsys
+import math
+import sys
+
+#-----------------------------------------------------------------------------
+
+VERSION = 1
+NUM_LEDS = 56
+COUNT_MAX = 64
+
+OP_SKIP = 0 << 6
+OP_RUN = 1 << 6
+OP_LIT = 2 << 6
+
+#-----------------------------------------------------------------------------
+# input
+
+def ppm_tokens(data):
+    """yield the header tokens of a ppm file and the offset of the pixel data"""
+    i = 0
+    tokens = []
+    while len(tokens) < 4:
+        while data[i:i + 1].isspace():
+            i += 1
+        if data[i:i + 1] == b'#':
+            while data[i:i + 1] not in (b'\n', b''):
+                i += 1
+            continue
+        j = i
+        while not data[j:j + 1].isspace():
+            j += 1
+        tokens.append(data[i:j])
+        i = j
+    return tokens, i + 1
+
+def read_ppm(fname):
+    """read a ppm file, return a list of frames of (r, g, b) tuples"""
+    data = open(fname, 'rb').read()
+    tokens, ofs = ppm_tokens(data)
+    magic, w, h, maxval = tokens[0], int(tokens[1]), int(tokens[2]), int(tokens[3])
+    if magic == b'P6':
+        if maxval > 255:
+            raise ValueError('%s: 16 bit ppm is not supported' % fname)
+        values = list(data[ofs:ofs + w * h * 3])
+    elif magic == b'P3':
+        values = [int(x) for x in data[ofs:].split()]
+    else:
+        raise ValueError('%s: not a ppm file' % fname)
+    if len(values) < w * h * 3:
+        raise ValueError('%s: short pixel data' % fname)
+    values = [(v * 255) // maxval for v in values]
+    frames = []
+    for y in range(h):
+        row = values[y * w * 3:(y + 1) * w * 3]
+        frames.append([tuple(row[x * 3:x * 3 + 3]) for x in range(w)])
+    return frames
+
+#-----------------------------------------------------------------------------
+# demo animations
+
+def rgb(h, s, v):
+    r, g, b = colorsys.hsv_to_rgb(h % 1.0, s, v)
+    return (int(r * 255), int(g * 255), int(b * 255))
+
+def demo_comet(n=NUM_LEDS):
+    """a comet with a fading tail bouncing along the keyboard"""
+    frames = []
+    path = list(range(n)) + list(range(n - 2, 0, -1))
+    for i, posn in enumerate(path):
+        frame = [(0, 0, 0)] * n
+        step = 1 if i < n else -1
+        for k in range(8):
+            x = posn - k * step
+            if 0 <= x < n:
+                frame[x] = rgb(i / len(path), 1.0, 1.0 / (1 << k))
+        frames.append(frame)
+    return frames
+
+def demo_bars(n=NUM_LEDS):
+    """coloured bars sliding in from both ends"""
+    frames = []
+    colors = [rgb(h / 6.0, 1.0, 1.0) for h in range(6)]
+    for c in colors:
+        for i in range(n // 2 + 1):
+            if frames:
+                frame = list(frames[-1])
+            else:
+                frame = [(0, 0, 0)] * n
+            for x in range(i):
+                frame[x] = c
+                frame[n - 1 - x] = c
+            frames.append(frame)
+    return frames
+
+def demo_plasma(n=NUM_LEDS):
+    """a slowly moving interference pattern"""
+    frames = []
+    for t in range(128):
+        frame = []
+        for x in range(n):
+            v = math.sin(x / 5.0 + t / 10.0) + math.sin(x / 9.0 - t / 7.0)
+            frame.append(rgb(v / 8.0 + t / 128.0, 1.0, 0.5))
+        frames.append(frame)
+    return frames
+
+demos = {
+    'comet': demo_comet,
+    'bars': demo_bars,
+    'plasma': demo_plasma,
+}
+
+#-----------------------------------------------------------------------------
+# palette
+
+def make_palette(frames):
+    """return a palette of <= 256 colours and the frames as palette indices"""
+    shift = 0
+    while True:
+        mask = (0xff << shift) & 0xff
+        scale = lambda x: ((x & mask) * 255) // mask
+        q = [[(scale(r), scale(g), scale(b)) for (r, g, b) in f] for f in frames]
+        colors = sorted(set(c for f in q for c in f))
+        if len(colors) <= 256:
+            break
+        shift += 1
+    if shift:
+        sys.stderr.write('palette: quantised to %d bits per channel\n' % (8 - shift))
+    index = {c: i for i, c in enumerate(colors)}
+    return colors, [[index[c] for c in f] for f in q]
+
+#-----------------------------------------------------------------------------
+# frame encoding
+
+def encode_frame(prev, cur):
+    """encode a frame (palette indices) against the previous frame"""
+    out = []
+    n = len(cur)
+    i = 0
+    lit = []
+
+    def flush_lit():
+        while lit:
+            chunk = lit[:COUNT_MAX]
+            del lit[:COUNT_MAX]
+            out.append(OP_LIT | (len(chunk) - 1))
+            out.extend(chunk)
+
+    while i < n:
+        # unchanged leds
+        j = i
+        while j < n and j - i < COUNT_MAX and cur[j] == prev[j]:
+            j += 1
+        skip = j - i
+        # same colour leds
+        j = i
+        while j < n and j - i < COUNT_MAX and cur[j] == cur[i]:
+            j += 1
+        run = j - i
+        if skip >= 2 or (skip == 1 and not lit):
+            flush_lit()
+            out.append(OP_SKIP | (skip - 1))
+            i += skip
+        elif run >= 3 or (run == 2 and not lit):
+            flush_lit()
+            out.append(OP_RUN | (run - 1))
+            out.append(cur[i])
+            i += run
+        else:
+            lit.append(cur[i])
+            i += 1
+    flush_lit()
+    return out
+
+def decode_frame(frame, data, ofs):
+    """reference decoder, used to check the encoding"""
+    i = 0
+    while i < len(frame):
+        op = data[ofs]
+        count = (op & 0x3f) + 1
+        ofs += 1
+        if op & 0xc0 == OP_RUN:
+            frame[i:i + count] = [data[ofs]] * count
+            ofs += 1
+        elif op & 0xc0 == OP_LIT:
+            frame[i:i + count] = data[ofs:ofs + count]
+            ofs += count
+        i += count
+    return ofs
+
+def encode(frames, msec):
+    """encode an animation, return the byte stream"""
+    n = len(frames[0])
+    if n > 255 or any(len(f) != n for f in frames):
+        raise ValueError('frames must all have the same number (< 256) of leds')
+    if len(frames) > 0xffff:
+        raise ValueError('too many frames')
+    colors, idx = make_palette(frames)
+    black = 0
+    if (0, 0, 0) in colors:
+        black = colors.index((0, 0, 0))
+    else:
+        # frame 0 is encoded against black, so it must be in the palette
+        colors = [(0, 0, 0)] + colors
+        idx = [[i + 1 for i in f] for f in idx]
+        if len(colors) > 256:
+            raise ValueError('no room for black in the palette')
+    out = [VERSION, n, len(frames) & 0xff, len(frames) >> 8, msec, len(colors) & 0xff]
+    for c in colors:
+        out.extend(c)
+    prev = [black] * n
+    for f in idx:
+        out.extend(encode_frame(prev, f))
+        prev = f
+    # check it
+    ofs = 6 + len(colors) * 3
+    frame = [black] * n
+    for f in idx:
+        ofs = decode_frame(frame, out, ofs)
+        assert frame == f
+    assert ofs == len(out)
+    return out
+
+#-----------------------------------------------------------------------------
+# output
+
+def c_array(name, data):
+    s = ['static const uint8_t %s[] PROGMEM = {' % name]
+    for i in range(0, len(data), 16):
+        s.append('    ' + ' '.join('0x%02x,' % x for x in data[i:i + 16]))
+    s.append('};')
+    return '\n'.join(s)
+
+def c_source(anims, cmd):
+    s = []
+    s.append('//' + '-' * 77)
+    s.append('/*\n\nAnimation Data\n\nGenerated by: %s\n\n*/' % cmd)
+    s.append('//' + '-' * 77)
+    s.append('')
+    s.append('#include <stdint.h>')
+    s.append('')
+    s.append('#include "hal.h"')
+    s.append('#include "color.h"')
+    s.append('#include "anim.h"')
+    s.append('')
+    s.append('//' + '-' * 77)
+    for name, desc, data in anims:
+        s.append('')
+        s.append('// %s: %d bytes' % (desc, len(data)))
+        s.append(c_array('anim_%s' % name, data))
+    s.append('')
+    s.append('//' + '-' * 77)
+    s.append('')
+    s.append('const uint8_t * const anim_table[] PROGMEM = {')
+    for name, _, _ in anims:
+        s.append('    anim_%s,' % name)
+    s.append('};')
+    s.append('')
+    s.append('const uint8_t anim_count = sizeof(anim_table) / sizeof(uint8_t *);')
+    s.append('')
+    s.append('//' + '-' * 77)
+    return '\n'.join(s) + '\n'
+
+#-----------------------------------------------------------------------------
+
+def main():
+    p = argparse.ArgumentParser(description='encode led animations for program memory')
+    p.add_argument('-o', dest='output', default='-', help='output file (default stdout)')
+    p.add_argument('--msec', type=int, default=33, help='msec per frame (default 33)')
+    p.add_argument('--demo', action='append', default=[], choices=sorted(demos), help='add a demo animation')
+    p.add_argument('inputs', nargs='*', metavar='name=file.ppm', help='add a ppm animation')
+    args = p.parse_args()
+
+    if not 0 < args.msec < 256:
+        p.error('msec must be 1..255')
+
+    sources = []
+    for name in args.demo:
+        sources.append((name, demos[name]()))
+    for arg in args.inputs:
+        name, _, fname = arg.partition('=')
+        if not fname or not name.isidentifier():
+            p.error('bad input %r, use name=file.ppm' % arg)
+        sources.append((name, read_ppm(fname)))
+    if not sources:
+        p.error('no animations')
+
+    anims = []
+    for name, frames in sources:
+        data = encode(frames, args.msec)
+        raw = len(frames) * len(frames[0]) * 3
+        desc = '%s, %d frames, %d leds, %d%% of raw' % (name, len(frames), len(frames[0]), (100 * len(data)) // raw)
+        sys.stderr.write(desc + ', %d bytes\n' % len(data))
+        anims.append((name, desc, data))
+
+    cmd = ' '.join(['animenc.py'] + sys.argv[1:])
+    src = c_source(anims, cmd)
+    if args.output == '-':
+        sys.stdout.write(src)
+    else:
+        open(args.output, 'w').write(src)
+
+main()
+
+#-----------------------------------------------------------------------------
@@ -0,0 +1,281 @@
+#!/usr/bin/env python3
+#-----------------------------------------------------------------------------
+"""
+
+LED Frame Viewer
+
+Render a led frame capture from the host build (midilights_host -c file).
+
+The capture is a header ("LEDC", version, leds, 2 zero bytes) followed by
+a record for each burst led_isr() pushed on the spi chain: a 32 bit usec
+timestamp, the led frame counter, the number of modules pushed n and n
+(blue, red, green) triples. Modules past n keep their earlier data.
+Version 2 captures also have a record (n with bit 7 set) for the led
+frame as each compose left it.
+
+Outputs:
+
+  --png FILE   timeline: a row per led frame period, a column block per led
+  --apng FILE  animation at the captured timing (animated png)
+  --csv FILE   a line per burst: time, frame, modules pushed, then r,g,b for
+               every led in the chain
+
+A summary of the frame pacing goes to stdout: the intervals between
+bursts (in frame periods), partial chain updates (bursts that pushed only
+the start of the chain) and any bursts whose frame counter doesn't match
+their timestamp (a late or missed isr).
+
+It also counts the torn bursts: those that match neither the compose
+before them nor the next one, so led_isr() sent a frame in the middle of
+a compose. The host build charges the compose its device time (see
+hal_host.cpp and layer.cpp) for this. The first few are listed by time.
+
+--dark LED MIN MAX checks that the led is lit and then goes dark (and
+stays dark) between MIN and MAX msecs of virtual time, exit status 1 if
+not. make hostcheck uses it for the stuck note timeout.
+
+Usage:
+
+  ledview.py capture.bin [--png out.png] [--apng out.png] [--csv out.csv]
+             [--scale N] [--period USEC] [--dark LED MIN MAX]
+
+"""
+#-----------------------------------------------------------------------------
+
+import argparse
+import struct
+import sys
+import zlib
+
+#-----------------------------------------------------------------------------
+
+MAGIC = b'LEDC'
+VERSIONS = (1, 2)
+HDR_SIZE = 8
+REC_SIZE = 6
+COMPOSE = 0x80      # record flag: the led frame after a compose
+
+# torn bursts to list
+TORN_LIST = 5
+
+# timer 0 overflow at 16 MHz / 1024 / 256
+FRAME_USEC = 16384
+
+#-----------------------------------------------------------------------------
+
+class Burst:
+    def __init__(self, usec, frame, n, leds):
+        self.usec = usec
+        self.frame = frame
+        self.n = n
+        self.leds = leds        # whole chain after this burst, (r, g, b)
+        self.torn = False
+
+# a burst is torn if its modules match neither the compose before it nor
+# the next one (the compose it interrupted)
+def check_torn(pending, before, after):
+    for burst, raw in pending:
+        n = len(raw)
+        if raw != before[:n] and (after is None or raw != after[:n]):
+            burst.torn = True
+
+def read_capture(name):
+    data = open(name, 'rb').read()
+    if len(data) < HDR_SIZE or data[:4] != MAGIC:
+        sys.exit('%s: not a led capture' % name)
+    version, nleds = data[4], data[5]
+    if version not in VERSIONS:
+        sys.exit('%s: version %d, expected one of %s' % (name, version, VERSIONS))
+    chain = [(0, 0, 0)] * nleds
+    bursts = []
+    composes = 0
+    composed = bytes(nleds * 3)     # the frame as the last compose left it
+    pending = []                    # bursts since then
+    posn = HDR_SIZE
+    while posn + REC_SIZE <= len(data):
+        usec, frame, n = struct.unpack_from('<IBB', data, posn)
+        posn += REC_SIZE
+        kind = n & COMPOSE
+        n &= ~COMPOSE
+        raw = data[posn:posn + n * 3]
+        posn += n * 3
+        if len(raw) < n * 3:
+            print('%s: truncated at burst %d' % (name, len(bursts)))
+            break
+        if kind:
+            check_torn(pending, composed, raw)
+            composed = raw
+            pending = []
+            composes += 1
+            continue
+        chain = list(chain)
+        for i in range(min(n, nleds)):
+            b, r, g = raw[i * 3:i * 3 + 3]
+            chain[i] = (r, g, b)
+        bursts.append(Burst(usec, frame, n, chain))
+        pending.append((bursts[-1], raw))
+    if composes:
+        check_torn(pending, composed, None)
+    return nleds, bursts, composes
+
+#-----------------------------------------------------------------------------
+# png
+
+def png_chunk(kind, body):
+    c = struct.pack('>I', len(body)) + kind + body
+    return c + struct.pack('>I', zlib.crc32(kind + body) & 0xffffffff)
+
+def png_rows(pixels, width):
+    # filter type 0 for each row of rgb pixels
+    out = bytearray()
+    for y in range(len(pixels) // width):
+        out.append(0)
+        for r, g, b in pixels[y * width:(y + 1) * width]:
+            out += bytes((r, g, b))
+    return zlib.compress(bytes(out), 9)
+
+def png_ihdr(width, height):
+    return png_chunk(b'IHDR', struct.pack('>IIBBBBB', width, height, 8, 2, 0, 0, 0))
+
+def strip_pixels(chain, scale, height):
+    row = []
+    for rgb in chain:
+        row += [rgb] * scale
+    return row * height
+
+def write_png(name, width, height, pixels):
+    with open(name, 'wb') as f:
+        f.write(b'\x89PNG\r\n\x1a\n')
+        f.write(png_ihdr(width, height))
+        f.write(png_chunk(b'IDAT', png_rows(pixels, width)))
+        f.write(png_chunk(b'IEND', b''))
+
+def write_apng(name, nleds, bursts, scale):
+    width, height = nleds * scale, scale
+    with open(name, 'wb') as f:
+        f.write(b'\x89PNG\r\n\x1a\n')
+        f.write(png_ihdr(width, height))
+        f.write(png_chunk(b'acTL', struct.pack('>II', len(bursts), 0)))
+        seq = 0
+        for i, b in enumerate(bursts):
+            nxt = bursts[i + 1].usec if i + 1 < len(bursts) else b.usec + FRAME_USEC
+            # delay in 1/10000 sec
+            delay = max(1, min(0xffff, (nxt - b.usec) // 100))
+            f.write(png_chunk(b'fcTL', struct.pack('>IIIIIHHBB', seq, width, height, 0, 0, delay, 10000, 0, 0)))
+            seq += 1
+            idat = png_rows(strip_pixels(b.leds, scale, height), width)
+            if i == 0:
+                f.write(png_chunk(b'IDAT', idat))
+            else:
+                f.write(png_chunk(b'fdAT', struct.pack('>I', seq) + idat))
+                seq += 1
+        f.write(png_chunk(b'IEND', b''))
+
+#-----------------------------------------------------------------------------
+
+def timeline(nleds, bursts, scale, period):
+    # a row per frame period, holding the chain state
+    t0 = bursts[0].usec
+    rows = (bursts[-1].usec - t0) // period + 1
+    pixels = []
+    j = 0
+    chain = bursts[0].leds
+    for row in range(rows):
+        t = t0 + row * period
+        while j < len(bursts) and bursts[j].usec <= t:
+            chain = bursts[j].leds
+            j += 1
+        pixels += strip_pixels(chain, scale, 1)
+    return nleds * scale, rows, pixels
+
+def write_csv(name, nleds, bursts):
+    with open(name, 'w') as f:
+        f.write('usec,frame,pushed,' + ','.join('r%d,g%d,b%d' % (i, i, i) for i in range(nleds)) + '\n')
+        for b in bursts:
+            f.write('%d,%d,%d,' % (b.usec, b.frame, b.n))
+            f.write(','.join('%d,%d,%d' % rgb for rgb in b.leds) + '\n')
+
+def summary(nleds, bursts, composes, period):
+    t = (bursts[-1].usec - bursts[0].usec) / 1e6
+    print('%d bursts over %.2f s, %d leds' % (len(bursts), t, nleds))
+    gaps = {}
+    late = 0
+    partial = 0
+    for a, b in zip(bursts, bursts[1:]):
+        n = round((b.usec - a.usec) / period)
+        gaps[n] = gaps.get(n, 0) + 1
+        if (a.frame + n) & 0xff != b.frame:
+            late += 1
+    for b in bursts:
+        if b.n < nleds:
+            partial += 1
+    if gaps:
+        print('interval (frame periods): ' +
+              ', '.join('%d: %d' % (n, gaps[n]) for n in sorted(gaps)))
+        print('longest gap %.1f ms' % (max(gaps) * period / 1e3))
+    print('partial chain updates: %d' % partial)
+    print('frame counter out of step: %d' % late)
+    if not composes:
+        print('torn bursts: not checked (no compose records)')
+        return
+    torn = [b for b in bursts if b.torn]
+    print('torn bursts: %d of %d (%d composes)' % (len(torn), len(bursts), composes))
+    for b in torn[:TORN_LIST]:
+        print('  torn at %.3f ms, frame %d' % (b.usec / 1e3, b.frame))
+
+# the led lights up, then goes dark for good between lo and hi msecs
+def check_dark(bursts, led, lo, hi):
+    lit = dark = None
+    for b in bursts:
+        on = b.leds[led] != (0, 0, 0)
+        if on and dark is not None:
+            return 'led %d lit again at %.3f ms' % (led, b.usec / 1e3)
+        if on and lit is None:
+            lit = b.usec
+        if not on and lit is not None and dark is None:
+            dark = b.usec
+    if lit is None:
+        return 'led %d never lit' % led
+    if dark is None:
+        return 'led %d still lit' % led
+    print('led %d lit at %.3f ms, dark at %.3f ms' % (led, lit / 1e3, dark / 1e3))
+    if not (lo * 1000 <= dark <= hi * 1000):
+        return 'led %d went dark outside %d..%d ms' % (led, lo, hi)
+    return None
+
+#-----------------------------------------------------------------------------
+
+def main():
+    p = argparse.ArgumentParser(description='render a led frame capture')
+    p.add_argument('capture')
+    p.add_argument('--png', help='timeline image')
+    p.add_argument('--apng', help='animated png')
+    p.add_argument('--csv', help='per burst csv')
+    p.add_argument('--scale', type=int, default=8, help='pixels per led')
+    p.add_argument('--period', type=int, default=FRAME_USEC, help='led frame period (usec)')
+    p.add_argument('--dark', type=int, nargs=3, metavar=('LED', 'MIN', 'MAX'),
+                   help='check the led goes dark between MIN and MAX msecs')
+    args = p.parse_args()
+
+    nleds, bursts, composes = read_capture(args.capture)
+    if not bursts:
+        sys.exit('%s: no frames' % args.capture)
+    summary(nleds, bursts, composes, args.period)
+    if args.png:
+        w, h, pixels = timeline(nleds, bursts, args.scale, args.period)
+        write_png(args.png, w, h, pixels)
+    if args.apng:
+        write_apng(args.apng, nleds, bursts, args.scale)
+    if args.csv:
+        write_csv(args.csv, nleds, bursts)
+    if args.dark:
+        led, lo, hi = args.dark
+        if led >= nleds:
+            sys.exit('led %d: the chain has %d' % (led, nleds))
+        err = check_dark(bursts, led, lo, hi)
+        if err:
+            sys.exit(err)
+
+main()
+
+#-----------------------------------------------------------------------------
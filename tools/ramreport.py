@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+#-----------------------------------------------------------------------------
+"""
+
+Static RAM Report
+
+The static ram (.data and .bss) of the firmware per module, from the
+symbols in the elf and their debug line info, with what is left for the
+stack. With the .su files of a -fstack-usage build (make ramreport
+STACK_USAGE=1) it also lists the largest stack frames.
+
+The total is the linker's: __heap_start, the end of .bss, less the start
+of sram. The symbols only break it down, anything without a size (libc
+objects, padding) is listed as unattributed.
+
+At run time ram.cpp gives the stack high water mark to compare with.
+It fails (exit status 1) if less than --stack bytes are left for the
+stack, so the budget is checked with every make ramreport.
+
+Usage:
+
+  ramreport.py [--nm avr-nm] [--ram 2048] [--stack 400] [-v] [--top N]
+               firmware.elf [*.su]
+
+"""
+#-----------------------------------------------------------------------------
+
+import argparse
+import os
+import subprocess
+import sys
+
+#-----------------------------------------------------------------------------
+
+# avr data space addresses in the elf
+RAM_BASE = 0x800000
+RAM_END = 0x810000
+
+# sram starts after the registers and io space
+RAM_START = RAM_BASE + 0x100
+
+NO_DEBUG = '(no line info)'
+
+#-----------------------------------------------------------------------------
+
+# return the sized ram symbols and the end of the static data
+def read_symbols(nm, elf):
+    try:
+        out = subprocess.run([nm, '-S', '-l', '-C', elf],
+                             check=True, capture_output=True, text=True).stdout
+    except (OSError, subprocess.CalledProcessError) as e:
+        sys.exit('%s: %s' % (nm, e))
+    syms = []
+    heap_start = None
+    for line in out.splitlines():
+        where = NO_DEBUG
+        if '\t' in line:
+            line, loc = line.split('\t', 1)
+            where = os.path.basename(loc.rsplit(':', 1)[0])
+        f = line.split(None, 3)
+        if (len(f) == 3) and (f[2] == '__heap_start'):
+            heap_start = int(f[0], 16)
+        if len(f) < 4:
+            continue
+        addr, size, kind, name = int(f[0], 16), int(f[1], 16), f[2], f[3]
+        if not (RAM_BASE <= addr < RAM_END):
+            continue
+        if kind in 'bB':
+            section = 'bss'
+        elif kind in 'dDrRvV':
+            section = 'data'
+        else:
+            continue
+        syms.append((where, section, size, name))
+    if heap_start is None:
+        sys.exit('%s: no __heap_start' % elf)
+    return syms, heap_start
+
+def read_stack_usage(names):
+    frames = []
+    for name in names:
+        for line in open(name):
+            f = line.rstrip('\n').split('\t')
+            if len(f) < 3:
+                continue
+            loc = f[0].split(':', 3)
+            frames.append((int(f[1]), f[2], os.path.basename(loc[0]), loc[-1]))
+    return frames
+
+#-----------------------------------------------------------------------------
+
+def main():
+    p = argparse.ArgumentParser(description='static ram per module')
+    p.add_argument('elf')
+    p.add_argument('su', nargs='*', help='-fstack-usage output files')
+    p.add_argument('--nm', default='avr-nm')
+    p.add_argument('--ram', type=int, default=2048, help='ram size (bytes)')
+    p.add_argument('--stack', type=int, default=0, help='least ram to leave for the stack')
+    p.add_argument('--top', type=int, default=10, help='stack frames to list')
+    p.add_argument('-v', action='store_true', help='list the symbols')
+    args = p.parse_args()
+
+    syms, heap_start = read_symbols(args.nm, args.elf)
+    modules = {}
+    for where, section, size, name in syms:
+        m = modules.setdefault(where, {'data': 0, 'bss': 0, 'syms': []})
+        m[section] += size
+        m['syms'].append((size, section, name))
+
+    total = {'data': 0, 'bss': 0}
+    print('%-20s %6s %6s %6s' % ('module', 'data', 'bss', 'total'))
+    for where in sorted(modules, key=lambda w: -(modules[w]['data'] + modules[w]['bss'])):
+        m = modules[where]
+        print('%-20s %6d %6d %6d' % (where, m['data'], m['bss'], m['data'] + m['bss']))
+        if args.v:
+            for size, section, name in sorted(m['syms'], reverse=True):
+                print('    %-30s %4s %6d' % (name, section, size))
+        total['data'] += m['data']
+        total['bss'] += m['bss']
+
+    used = heap_start - RAM_START
+    other = used - (total['data'] + total['bss'])
+    print('%-20s %6s %6s %6d' % ('(unattributed)', '', '', other))
+    print('%-20s %6d %6d %6d' % ('total', total['data'], total['bss'], used))
+    print('%d of %d bytes static (%.1f%%), %d for the stack' %
+          (used, args.ram, 100.0 * used / args.ram, args.ram - used))
+
+    frames = read_stack_usage(args.su)
+    if frames:
+        print()
+        print('largest stack frames:')
+        for size, kind, module, func in sorted(frames, reverse=True)[:args.top]:
+            print('%6d  %-8s %-12s %s' % (size, kind, module, func))
+
+    if args.ram - used < args.stack:
+        sys.exit('%d bytes for the stack, the budget is %d' % (args.ram - used, args.stack))
+
+main()
+
+#-----------------------------------------------------------------------------
@@ -0,0 +1,465 @@
+//-----------------------------------------------------------------------------
+/*
+
+Cycle Benchmark
+
+Runs a BENCH firmware build (see src/bench.h) under simavr. A scenario
+script presses keys and sends MIDI input. The result goes to stdout as
+JSON.
+
+usage: simbench [-f hz] firmware.elf scenario.txt
+
+Scenario lines are "<msec> <command> <args>", # starts a comment:
+
+    100 key 3 down      close key 3 (row 3 % 7, column 3 / 7)
+    300 key 3 up
+    400 midi 90 3c 64   queue bytes (hex) on the uart input
+    5000 end            stop (default: 1 sec after the last line)
+
+The report has:
+
+- probes: cycles per call between the BENCH_BEGIN/BENCH_END markers,
+  less the time spent in any probed isr that interrupted it. max_incl
+  includes those isrs. The isr probes are inside the vector, so the
+  register save/restore (about 40 cycles) isn't counted.
+- isr_worst: the longest isr.
+- key_latency: time from a key closing or opening to the uart data
+  register write of its note on/off status byte. Pending key changes
+  are matched to the status bytes in order, so chords get a latency
+  each. Received notes are merged into the output, so keep the midi
+  input clear of key changes.
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_io.h>
+#include <simavr/avr_ioport.h>
+#include <simavr/avr_uart.h>
+
+//-----------------------------------------------------------------------------
+
+// must match src/bench.h
+#define BENCH_END_FLAG 0x80
+#define BENCH_ISR_FIRST 0x10
+#define BENCH_ISR_LAST 0x3f
+#define BENCH_EFFECT_FIRST 0x40
+
+#define GPIOR0_ADDR 0x3e    // data space address
+
+// must match src/key.h
+#define KEY_ROWS 7
+#define KEY_COLS 4
+#define NUM_KEYS (KEY_ROWS * KEY_COLS)
+
+#define MAX_EVENTS 1024
+#define MAX_DEPTH 8
+#define MAX_PRESSES 256
+
+//-----------------------------------------------------------------------------
+
+static const char *probe_names[BENCH_EFFECT_FIRST] = {
+    [0x01] = "key_scan",
+    [0x02] = "midi_rx",
+    [0x03] = "frame",
+    [0x10] = "uart_rx_isr",
+    [0x11] = "uart_tx_isr",
+    [0x12] = "led_isr",
+    [0x13] = "timer_ovf_isr",
+    [0x14] = "timer_alarm_isr",
+};
+
+typedef struct probe {
+    uint64_t count;
+    uint64_t total;         // exclusive cycles
+    uint64_t min;
+    uint64_t max;
+    uint64_t max_incl;      // including nested isrs
+} PROBE;
+
+typedef struct frame {
+    uint8_t id;
+    uint64_t start;
+    uint64_t nested;        // cycles in nested probes
+} FRAME;
+
+enum {
+    EV_KEY_DOWN,
+    EV_KEY_UP,
+    EV_MIDI,
+    EV_END,
+};
+
+typedef struct event {
+    uint64_t cycle;
+    int type;
+    int key;
+    uint8_t data[16];
+    int len;
+} EVENT;
+
+typedef struct press {
+    int key;
+    int down;
+    uint64_t cycle;         // key change
+    uint64_t latency;       // cycles to the status byte, 0 = none seen
+} PRESS;
+
+static avr_t *avr;
+static uint32_t freq = 16000000;
+
+static PROBE probes[128];
+static FRAME stack[MAX_DEPTH];
+static int depth;
+static uint64_t unmatched;
+
+static EVENT events[MAX_EVENTS];
+static int nevents;
+
+static uint8_t key_down[NUM_KEYS];
+static uint8_t key_row;
+static avr_irq_t *col_irq[KEY_COLS];
+
+static PRESS presses[MAX_PRESSES];
+static int npresses;
+static int press_next;          // oldest press waiting for its midi out
+
+//-----------------------------------------------------------------------------
+// probe register
+
+static void probe_write(struct avr_t *avr, avr_io_addr_t addr, uint8_t v, void *param) {
+    avr->data[addr] = v;
+    uint8_t id = v & ~BENCH_END_FLAG;
+    uint64_t now = avr->cycle;
+
+    if (!(v & BENCH_END_FLAG)) {
+        if (depth < MAX_DEPTH) {
+            stack[depth].id = id;
+            stack[depth].start = now;
+            stack[depth].nested = 0;
+        }
+        depth += 1;
+        return;
+    }
+    if ((depth == 0) || (depth > MAX_DEPTH) || (stack[depth - 1].id != id)) {
+        // out of step (reset, or a probe missing its end)
+        unmatched += 1;
+        depth = 0;
+        return;
+    }
+    depth -= 1;
+    FRAME *f = &stack[depth];
+    uint64_t incl = now - f->start;
+    uint64_t excl = incl - f->nested;
+    if (depth > 0) {
+        stack[depth - 1].nested += incl;
+    }
+    PROBE *p = &probes[id];
+    if ((p->count == 0) || (excl < p->min)) {
+        p->min = excl;
+    }
+    if (excl > p->max) {
+        p->max = excl;
+    }
+    if (incl > p->max_incl) {
+        p->max_incl = incl;
+    }
+    p->total += excl;
+    p->count += 1;
+}
+
+//-----------------------------------------------------------------------------
+// key matrix
+
+// drive the column inputs for the selected row (closed = low)
+static void key_columns(void) {
+    for (int c = 0; c < KEY_COLS; c ++) {
+        int key = key_row + (c * KEY_ROWS);
+        avr_raise_irq(col_irq[c], (key_row < KEY_ROWS) && key_down[key] ? 0 : 1);
+    }
+}
+
+static void row_write(struct avr_irq_t *irq, uint32_t value, void *param) {
+    key_row = value & 7;
+    key_columns();
+}
+
+static void key_set(int key, int down) {
+    key_down[key] = down;
+    key_columns();
+    if (npresses < MAX_PRESSES) {
+        PRESS *p = &presses[npresses];
+        p->key = key;
+        p->down = down;
+        p->cycle = avr->cycle;
+        p->latency = 0;
+        npresses += 1;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// uart
+
+static void uart_out(struct avr_irq_t *irq, uint32_t value, void *param) {
+    uint8_t c = value;
+    // note off/on status byte, for the oldest waiting press
+    if ((press_next < npresses) && ((c & 0xe0) == 0x80)) {
+        PRESS *p = &presses[press_next];
+        p->latency = avr->cycle - p->cycle;
+        press_next += 1;
+    }
+}
+
+static void uart_in(const uint8_t *buf, int len) {
+    avr_irq_t *irq = avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_INPUT);
+    for (int i = 0; i < len; i ++) {
+        avr_raise_irq(irq, buf[i]);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// scenario
+
+static uint64_t msec_to_cycles(double msec) {
+    return (uint64_t)(msec * (freq / 1000));
+}
+
+static int read_scenario(const char *name) {
+    FILE *f = fopen(name, "r");
+    if (!f) {
+        perror(name);
+        return -1;
+    }
+    char line[256];
+    int lineno = 0;
+    int end = 0;
+    uint64_t last = 0;
+
+    while (fgets(line, sizeof(line), f)) {
+        lineno += 1;
+        char *s = strchr(line, '#');
+        if (s) {
+            *s = 0;
+        }
+        double msec;
+        char cmd[16];
+        int n = 0;
+        if (sscanf(line, " %lf %15s %n", &msec, cmd, &n) < 2) {
+            continue;
+        }
+        if (nevents >= MAX_EVENTS) {
+            fprintf(stderr, "%s:%d: too many events\n", name, lineno);
+            break;
+        }
+        EVENT *e = &events[nevents];
+        memset(e, 0, sizeof(EVENT));
+        e->cycle = msec_to_cycles(msec);
+        s = n ? (line + n) : (line + strlen(line));
+        if (!strcmp(cmd, "key")) {
+            char dir[8];
+            if ((sscanf(s, "%d %7s", &e->key, dir) != 2) || (e->key < 0) || (e->key >= NUM_KEYS)) {
+                fprintf(stderr, "%s:%d: bad key\n", name, lineno);
+                goto fail;
+            }
+            e->type = strcmp(dir, "up") ? EV_KEY_DOWN : EV_KEY_UP;
+        } else if (!strcmp(cmd, "midi")) {
+            unsigned x;
+            int k;
+            e->type = EV_MIDI;
+            while ((e->len < (int)sizeof(e->data)) && (sscanf(s, "%x%n", &x, &k) == 1)) {
+                e->data[e->len ++] = x;
+                s += k;
+            }
+        } else if (!strcmp(cmd, "end")) {
+            e->type = EV_END;
+            end = 1;
+        } else {
+            fprintf(stderr, "%s:%d: unknown command %s\n", name, lineno, cmd);
+            goto fail;
+        }
+        if (e->cycle < last) {
+            fprintf(stderr, "%s:%d: out of order\n", name, lineno);
+            goto fail;
+        }
+        last = e->cycle;
+        nevents += 1;
+    }
+    fclose(f);
+    if (!end && (nevents < MAX_EVENTS)) {
+        events[nevents].type = EV_END;
+        events[nevents].cycle = last + msec_to_cycles(1000);
+        nevents += 1;
+    }
+    return 0;
+
+fail:
+    fclose(f);
+    return -1;
+}
+
+//-----------------------------------------------------------------------------
+// report
+
+static double cycles_to_usec(uint64_t cycles) {
+    return (double)cycles * 1e6 / freq;
+}
+
+static void report(const char *elf) {
+    printf("{\n");
+    printf("  \"firmware\": \"%s\",\n", elf);
+    printf("  \"f_cpu\": %u,\n", freq);
+    printf("  \"cycles\": %llu,\n", (unsigned long long)avr->cycle);
+    printf("  \"unmatched\": %llu,\n", (unsigned long long)unmatched);
+
+    // per probe
+    int worst = -1;
+    int first = 1;
+    printf("  \"probes\": {");
+    for (int id = 1; id < 128; id ++) {
+        PROBE *p = &probes[id];
+        if (p->count == 0) {
+            continue;
+        }
+        char name[32];
+        if (id >= BENCH_EFFECT_FIRST) {
+            snprintf(name, sizeof(name), "effect_%d", id - BENCH_EFFECT_FIRST);
+        } else if (probe_names[id]) {
+            snprintf(name, sizeof(name), "%s", probe_names[id]);
+        } else {
+            snprintf(name, sizeof(name), "probe_%02x", id);
+        }
+        printf("%s\n    \"%s\": {\"count\": %llu, \"min\": %llu, \"mean\": %llu, \"max\": %llu, \"max_incl\": %llu}",
+            first ? "" : ",", name, (unsigned long long)p->count, (unsigned long long)p->min,
+            (unsigned long long)(p->total / p->count), (unsigned long long)p->max,
+            (unsigned long long)p->max_incl);
+        first = 0;
+        if ((id >= BENCH_ISR_FIRST) && (id <= BENCH_ISR_LAST) &&
+            ((worst < 0) || (p->max_incl > probes[worst].max_incl))) {
+            worst = id;
+        }
+    }
+    printf("\n  },\n");
+
+    if (worst >= 0) {
+        printf("  \"isr_worst\": {\"name\": \"%s\", \"cycles\": %llu, \"usec\": %.2f},\n",
+            probe_names[worst] ? probe_names[worst] : "?", (unsigned long long)probes[worst].max_incl,
+            cycles_to_usec(probes[worst].max_incl));
+    }
+
+    // key press to midi out
+    uint64_t lmin = 0, lmax = 0, ltotal = 0;
+    int seen = 0;
+    printf("  \"key_latency\": {\n    \"events\": [");
+    for (int i = 0; i < npresses; i ++) {
+        PRESS *p = &presses[i];
+        printf("%s\n      {\"key\": %d, \"down\": %d, \"msec\": %.3f, \"usec\": ", i ? "," : "",
+            p->key, p->down, cycles_to_usec(p->cycle) / 1000.0);
+        if (p->latency) {
+            printf("%.1f}", cycles_to_usec(p->latency));
+            if (!seen || (p->latency < lmin)) {
+                lmin = p->latency;
+            }
+            if (p->latency > lmax) {
+                lmax = p->latency;
+            }
+            ltotal += p->latency;
+            seen += 1;
+        } else {
+            printf("null}");
+        }
+    }
+    printf("\n    ],\n");
+    printf("    \"count\": %d,\n", seen);
+    printf("    \"min_usec\": %.1f,\n", seen ? cycles_to_usec(lmin) : 0.0);
+    printf("    \"mean_usec\": %.1f,\n", seen ? cycles_to_usec(ltotal / seen) : 0.0);
+    printf("    \"max_usec\": %.1f\n", seen ? cycles_to_usec(lmax) : 0.0);
+    printf("  }\n");
+    printf("}\n");
+}
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    int c;
+
+    while ((c = getopt(argc, argv, "f:")) != -1) {
+        switch (c) {
+            case 'f': freq = strtoul(optarg, 0, 0); break;
+            default: goto usage;
+        }
+    }
+    if (argc - optind != 2) {
+        goto usage;
+    }
+    const char *elf = argv[optind];
+    if (read_scenario(argv[optind + 1]) != 0) {
+        return 1;
+    }
+
+    elf_firmware_t fw;
+    memset(&fw, 0, sizeof(fw));
+    if (elf_read_firmware(elf, &fw) != 0) {
+        fprintf(stderr, "%s: can't load\n", elf);
+        return 1;
+    }
+    avr = avr_make_mcu_by_name("atmega328p");
+    if (!avr) {
+        fprintf(stderr, "no atmega328p in simavr\n");
+        return 1;
+    }
+    avr_init(avr);
+    avr_load_firmware(avr, &fw);
+    avr->frequency = freq;
+    avr->log = LOG_ERROR;
+
+    // probe register
+    avr_register_io_write(avr, GPIOR0_ADDR, probe_write, 0);
+
+    // key matrix: rows on port b 0..2, columns on port c 0..3
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), IOPORT_IRQ_REG_PORT), row_write, 0);
+    for (int i = 0; i < KEY_COLS; i ++) {
+        col_irq[i] = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('C'), i);
+    }
+    key_columns();
+
+    // uart: keep the output off stdout, watch it for note messages
+    uint32_t flags = 0;
+    avr_ioctl(avr, AVR_IOCTL_UART_GET_FLAGS('0'), &flags);
+    flags &= ~AVR_UART_FLAG_STDIO;
+    avr_ioctl(avr, AVR_IOCTL_UART_SET_FLAGS('0'), &flags);
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT), uart_out, 0);
+
+    int ev = 0;
+    for (;;) {
+        while ((ev < nevents) && (avr->cycle >= events[ev].cycle)) {
+            EVENT *e = &events[ev ++];
+            switch (e->type) {
+                case EV_KEY_DOWN: key_set(e->key, 1); break;
+                case EV_KEY_UP: key_set(e->key, 0); break;
+                case EV_MIDI: uart_in(e->data, e->len); break;
+                default: goto done;
+            }
+        }
+        int state = avr_run(avr);
+        if ((state == cpu_Done) || (state == cpu_Crashed)) {
+            fprintf(stderr, "simulation stopped at cycle %llu\n", (unsigned long long)avr->cycle);
+            break;
+        }
+    }
+done:
+    report(elf);
+    return 0;
+
+usage:
+    fprintf(stderr, "usage: %s [-f hz] firmware.elf scenario.txt\n", argv[0]);
+    return 1;
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+#-----------------------------------------------------------------------------
+"""
+
+Telemetry Monitor
+
+Poll the piano's health telemetry (see src/telem.cpp) over midi and show
+it as a live table with a sparkline graph of each value.
+
+The request (F0 7D 30 F7) goes out and the reply is read back with alsa's
+amidi, so nothing beyond alsa-utils is needed:
+
+  telemon.py --port hw:1,0 [--interval 1.0] [--csv log.csv]
+
+Counters that wrap (bytes, led frames) are shown as rates per second from
+the difference between polls. --csv writes a line per poll with the raw
+values.
+
+The replies in a capture can be decoded offline (raw midi bytes, or hex
+text with --hex), e.g. from the host build:
+
+  midilights_host -o out.bin requests.bin
+  telemon.py --file out.bin
+
+"""
+#-----------------------------------------------------------------------------
+
+import argparse
+import re
+import subprocess
+import sys
+import time
+
+#-----------------------------------------------------------------------------
+
+TELEM_ID = 0x7d
+TELEM_CMD = 0x30
+REQUEST = 'F0 7D 30 F7'
+
+# (page, index, name, kind): kind is 'value', 'counter' (wraps, shown as a
+# rate) or 'ticks' (0.5 usec timer ticks, shown in usecs)
+FIELDS = [
+    (0, 2, 'loop rate', 'value'),
+    (0, 3, 'key scans/s', 'value'),
+    (0, 4, 'busy %', 'duty'),
+    (0, 5, 'led frames/s', 'counter'),
+    (0, 6, 'led skipped/s', 'counter'),
+    (0, 7, 'ram free min', 'value'),
+    (0, 8, 'stack max', 'value'),
+    (0, 9, 'isr rx wait us', 'ticks'),
+    (0, 10, 'led isr max us', 'ticks'),
+    (0, 11, 'boot fails', 'value'),
+    (0, 12, 'boot usec', 'value'),
+    (1, 0, 'rx bytes/s', 'counter'),
+    (1, 1, 'tx bytes/s', 'counter'),
+    (1, 2, 'rx parity', 'value'),
+    (1, 3, 'rx framing', 'value'),
+    (1, 4, 'rx overrun', 'value'),
+    (1, 5, 'rx overflow', 'value'),
+    (1, 6, 'rx depth max', 'value'),
+    (1, 7, 'tx depth max', 'value'),
+    (1, 8, 'merge depth max', 'value'),
+    (1, 9, 'merge dropped', 'value'),
+    (1, 10, 'merge lat max us', 'value'),
+    (1, 11, 'log depth max', 'value'),
+]
+
+SPARK = ' .:-=+*#%@'
+HISTORY = 40
+
+#-----------------------------------------------------------------------------
+
+def telem_pages(data):
+    # the telemetry replies in a midi byte stream, as {page: [values]}
+    msg = None
+    for c in data:
+        if c == 0xf0:
+            msg = []
+        elif c == 0xf7:
+            if msg and len(msg) >= 4 and msg[0] == TELEM_ID and msg[1] == TELEM_CMD:
+                page, n = msg[2], msg[3]
+                raw = msg[4:4 + n * 3]
+                if len(raw) == n * 3:
+                    yield page, [raw[i] | (raw[i + 1] << 7) | (raw[i + 2] << 14)
+                                 for i in range(0, n * 3, 3)]
+            msg = None
+        elif c >= 0xf8:
+            pass
+        elif c & 0x80:
+            msg = None
+        elif msg is not None:
+            msg.append(c)
+
+def samples(data):
+    # a sample is page 0 followed by page 1
+    sample = {}
+    for page, values in telem_pages(data):
+        if page == 0 and sample:
+            yield sample
+            sample = {}
+        sample[page] = values
+    if sample:
+        yield sample
+
+def uptime(s):
+    v = s.get(0, [])
+    return (v[0] | (v[1] << 16)) / 1000.0 if len(v) > 1 else None
+
+def field(s, page, index):
+    v = s.get(page, [])
+    return v[index] if index < len(v) else None
+
+#-----------------------------------------------------------------------------
+
+class Monitor:
+    def __init__(self, csv):
+        self.prev = None
+        self.history = {f[2]: [] for f in FIELDS}
+        self.csv = open(csv, 'a') if csv else None
+        if self.csv and self.csv.tell() == 0:
+            self.csv.write('uptime,' + ','.join(f[2] for f in FIELDS) + '\n')
+
+    def update(self, s):
+        t = uptime(s)
+        dt = None
+        if self.prev is not None and t is not None and uptime(self.prev) is not None:
+            dt = t - uptime(self.prev)
+        shown = {}
+        for page, index, name, kind in FIELDS:
+            x = field(s, page, index)
+            if x is None:
+                continue
+            if kind == 'counter':
+                p = field(self.prev, page, index) if self.prev else None
+                if p is None or not dt or dt <= 0:
+                    continue
+                x = ((x - p) & 0xffff) / dt
+            elif kind == 'ticks':
+                x = x / 2.0
+            elif kind == 'duty':
+                x = x / 10.0
+            shown[name] = x
+            h = self.history[name]
+            h.append(x)
+            del h[:-HISTORY]
+        if self.csv:
+            self.csv.write('%s,' % ('' if t is None else '%.3f' % t))
+            self.csv.write(','.join('' if field(s, p, i) is None else str(field(s, p, i))
+                                    for p, i, _, _ in FIELDS) + '\n')
+            self.csv.flush()
+        self.prev = s
+        return t, shown
+
+    def spark(self, name):
+        h = self.history[name]
+        if not h:
+            return ''
+        lo, hi = min(h), max(h)
+        span = (hi - lo) or 1
+        return ''.join(SPARK[int((x - lo) * (len(SPARK) - 1) / span)] for x in h)
+
+    def show(self, t, shown, clear):
+        out = []
+        if clear:
+            out.append('\x1b[H\x1b[2J')
+        out.append('uptime %s' % ('?' if t is None else '%.1f s' % t))
+        for name in (f[2] for f in FIELDS):
+            if name in shown:
+                out.append('%-18s %10.1f  %s' % (name, shown[name], self.spark(name)))
+        print('\n'.join(out))
+        sys.stdout.flush()
+
+#-----------------------------------------------------------------------------
+
+def poll(port, wait):
+    cmd = ['amidi', '-p', port, '-S', REQUEST, '-d', '-t', str(wait)]
+    try:
+        out = subprocess.run(cmd, capture_output=True, timeout=wait + 5).stdout
+    except (OSError, subprocess.TimeoutExpired) as e:
+        sys.exit('amidi: %s' % e)
+    return bytes(int(x, 16) for x in re.findall(rb'\b[0-9a-fA-F]{2}\b', out))
+
+def main():
+    p = argparse.ArgumentParser(description='piano health telemetry')
+    p.add_argument('--port', help='alsa raw midi port (amidi -l)')
+    p.add_argument('--interval', type=float, default=1.0, help='seconds between polls')
+    p.add_argument('--file', help='decode a capture instead of polling')
+    p.add_argument('--hex', action='store_true', help='the capture is hex text')
+    p.add_argument('--csv', help='append the raw values to a csv file')
+    p.add_argument('--request', action='store_true', help='print the request')
+    args = p.parse_args()
+
+    if args.request:
+        print(REQUEST)
+        return
+    mon = Monitor(args.csv)
+    if args.file:
+        data = open(args.file, 'rb').read()
+        if args.hex:
+            data = bytes(int(x, 16) for x in re.findall(rb'\b[0-9a-fA-F]{2}\b', data))
+        n = 0
+        for s in samples(data):
+            t, shown = mon.update(s)
+            mon.show(t, shown, False)
+            print()
+            n += 1
+        if n == 0:
+            sys.exit('no telemetry replies found')
+        return
+    if not args.port:
+        sys.exit('need --port or --file')
+    # the reply is ~90 bytes, 30 msec at 31250 baud
+    wait = min(0.5, args.interval)
+    while True:
+        t0 = time.time()
+        for s in samples(poll(args.port, wait)):
+            t, shown = mon.update(s)
+            mon.show(t, shown, True)
+        time.sleep(max(0, args.interval - (time.time() - t0)))
+
+try:
+    main()
+except KeyboardInterrupt:
+    pass
+
+#-----------------------------------------------------------------------------
@@ -0,0 +1,265 @@
+#!/usr/bin/env python3
+#-----------------------------------------------------------------------------
+"""
+
+Event Trace Decoder
+
+Decode the event trace dumps (see src/trace.cpp) in a midi capture from
+the piano: a timeline of the events and the latencies between them.
+
+The firmware ring holds the last 4 events (make TRACE_SIZE=16 for more),
+the host build's 32. The dump request is F0 7D 20 F7 (--request
+prints it). Send it and record the reply, e.g. with alsa:
+
+  amidi -p hw:1 -S 'F0 7D 20 F7' -d -t 2 > dump.txt
+  tracedump.py --hex dump.txt
+
+or from the host build:
+
+  midilights_host -o out.bin request.bin
+  tracedump.py out.bin
+
+Input is raw midi bytes, or with --hex any text of hex byte pairs. Other
+midi traffic around the dumps is ignored. Several dumps make one timeline,
+but the latencies are only taken within a dump.
+
+Latencies (usecs):
+
+  key -> note out    key edge to the note on/off being queued for the uart
+  byte -> message    status byte received to the message being parsed
+  queued (forward)   message parsed to being forwarded (merge)
+  frame render       frame task start to end
+  frame -> leds      frame task end (with changes) to the next led isr push
+  led frame period   between led isr pushes
+  lcd flush          lcd_flush() start to end
+
+Usage:
+
+  tracedump.py [--hex] [--quiet] [--request] [file]
+
+"""
+#-----------------------------------------------------------------------------
+
+import argparse
+import re
+import sys
+
+#-----------------------------------------------------------------------------
+
+TRACE_ID = 0x7d
+CMD_DUMP = 0x20
+DUMP_HEADER = 0
+DUMP_RECORD = 1
+DUMP_END = 2
+VERSION = 2
+
+# record timestamps: 0.5 usec ticks, 24 bits
+TICK_MASK = 0xffffff
+
+# MIDI_FWD queued time units (usecs)
+FWD_UNIT = 64
+
+EVENTS = {
+    1: 'KEY_DOWN',
+    2: 'KEY_UP',
+    3: 'UART_RX',
+    4: 'MIDI_RX',
+    5: 'MIDI_TX',
+    6: 'MIDI_FWD',
+    7: 'FRAME_START',
+    8: 'FRAME_END',
+    9: 'LED_PUSH',
+    10: 'LCD_START',
+    11: 'LCD_END',
+    12: 'MARK',
+}
+
+#-----------------------------------------------------------------------------
+
+class Event:
+    def __init__(self, usec, id, a, b):
+        self.usec = usec
+        self.id = id
+        self.a = a
+        self.b = b
+
+    def name(self):
+        return EVENTS.get(self.id, 'ID_%d' % self.id)
+
+    def detail(self):
+        n = self.name()
+        if n in ('KEY_DOWN', 'KEY_UP'):
+            return 'key %d' % self.a
+        if n == 'UART_RX':
+            return '%02x (rx depth %d)' % (self.a, self.b)
+        if n in ('MIDI_RX', 'MIDI_TX'):
+            return '%02x %02x' % (self.a, self.b)
+        if n == 'MIDI_FWD':
+            return '%02x queued %s%d us' % (self.a, '>= ' if self.b == 255 else '', self.b * FWD_UNIT)
+        if n in ('FRAME_START', 'FRAME_END'):
+            return 'frame %d%s' % (self.a, ' changed' if (n == 'FRAME_END' and self.b) else '')
+        if n == 'LED_PUSH':
+            return 'frame %d, %d modules' % (self.a, self.b)
+        if n == 'LCD_END':
+            return 'more' if self.b else ''
+        return '%d %d' % (self.a, self.b)
+
+def val7(data):
+    # 7 bit groups, least significant first
+    x = 0
+    for i, c in enumerate(data):
+        x |= c << (7 * i)
+    return x
+
+#-----------------------------------------------------------------------------
+
+def sysex_messages(data):
+    msg = None
+    for c in data:
+        if c == 0xf0:
+            msg = []
+        elif c == 0xf7:
+            if msg is not None:
+                yield msg
+            msg = None
+        elif c >= 0xf8:
+            pass                # realtime may come between any bytes
+        elif c & 0x80:
+            msg = None          # cut short
+        elif msg is not None:
+            msg.append(c)
+
+def decode(data):
+    dumps = []
+    dump = None
+    for m in sysex_messages(data):
+        if len(m) < 3 or m[0] != TRACE_ID or m[1] != CMD_DUMP:
+            continue
+        kind = m[2]
+        if kind == DUMP_HEADER and len(m) >= 18:
+            if m[3] != VERSION:
+                print('dump version %d, expected %d' % (m[3], VERSION))
+            dump = {'count': m[4], 'size': m[5], 'missed': val7(m[6:9]),
+                    'now': val7(m[9:14]), 'ticks': val7(m[14:18]), 'events': []}
+            dumps.append(dump)
+        elif kind == DUMP_RECORD and len(m) >= 12 and dump is not None:
+            # ticks back from the header's, on its usec time
+            age = (dump['ticks'] - val7(m[8:12])) & TICK_MASK
+            usec = (dump['now'] - (age >> 1)) & 0xffffffff
+            dump['events'].append(Event(usec, m[3], val7(m[4:6]), val7(m[6:8])))
+        elif kind == DUMP_END and dump is not None:
+            if len(dump['events']) != dump['count']:
+                print('dump of %d records, %d received' % (dump['count'], len(dump['events'])))
+            dump = None
+    return dumps
+
+def unwrap(dumps):
+    # one timeline, the 32 bit usec counter wraps every 71.6 minutes
+    events = []
+    base = 0
+    last = None
+    for d in dumps:
+        for e in d['events']:
+            t = e.usec + base
+            if last is not None and t < last - (1 << 31):
+                base += 1 << 32
+                t += 1 << 32
+            e.usec = t
+            last = t
+            events.append(e)
+    return events
+
+#-----------------------------------------------------------------------------
+# latencies
+
+def pair(events, start, end, match):
+    # each start event to the first following end event that matches it
+    out = []
+    open_ = []
+    for e in events:
+        if e.name() == end:
+            for s in open_:
+                if match(s, e):
+                    out.append(e.usec - s.usec)
+                    open_.remove(s)
+                    break
+        if e.name() == start:
+            open_.append(e)
+    return out
+
+def key_match(s, e):
+    status = e.a & 0xf0
+    if s.name() == 'KEY_DOWN':
+        return status == 0x90
+    return status == 0x80
+
+def latencies(events):
+    lat = {}
+    lat['key -> note out'] = pair(events, 'KEY_DOWN', 'MIDI_TX', key_match) + \
+                             pair(events, 'KEY_UP', 'MIDI_TX', key_match)
+    lat['byte -> message'] = pair(events, 'UART_RX', 'MIDI_RX', lambda s, e: s.a == e.a)
+    lat['queued (forward)'] = [e.b * FWD_UNIT for e in events if e.name() == 'MIDI_FWD']
+    lat['frame render'] = pair(events, 'FRAME_START', 'FRAME_END', lambda s, e: s.a == e.a)
+    changed = [e for e in events if e.name() == 'LED_PUSH' or (e.name() == 'FRAME_END' and e.b)]
+    lat['frame -> leds'] = pair(changed, 'FRAME_END', 'LED_PUSH', lambda s, e: True)
+    pushes = [e.usec for e in events if e.name() == 'LED_PUSH']
+    lat['led frame period'] = [b - a for a, b in zip(pushes, pushes[1:])]
+    lat['lcd flush'] = pair(events, 'LCD_START', 'LCD_END', lambda s, e: True)
+    return lat
+
+def print_latencies(lat):
+    print('%-18s %6s %8s %8s %8s' % ('latency (usec)', 'n', 'min', 'mean', 'max'))
+    for name, v in lat.items():
+        if not v:
+            continue
+        print('%-18s %6d %8d %8d %8d' % (name, len(v), min(v), sum(v) // len(v), max(v)))
+
+def print_timeline(events):
+    t0 = events[0].usec
+    prev = t0
+    for e in events:
+        print('%12.3f ms %+9d us  %-12s %s' % ((e.usec - t0) / 1e3, e.usec - prev, e.name(), e.detail()))
+        prev = e.usec
+
+#-----------------------------------------------------------------------------
+
+def read_input(name, hex_text):
+    f = open(name, 'rb') if name else sys.stdin.buffer
+    data = f.read()
+    if hex_text:
+        data = bytes(int(x, 16) for x in re.findall(rb'\b[0-9a-fA-F]{2}\b', data))
+    return data
+
+def main():
+    p = argparse.ArgumentParser(description='decode event trace dumps')
+    p.add_argument('file', nargs='?', help='midi capture (default stdin)')
+    p.add_argument('--hex', action='store_true', help='input is hex text')
+    p.add_argument('--quiet', action='store_true', help='latencies only')
+    p.add_argument('--request', action='store_true', help='print the dump request')
+    args = p.parse_args()
+
+    if args.request:
+        print('F0 %02X %02X F7' % (TRACE_ID, CMD_DUMP))
+        return
+
+    dumps = decode(read_input(args.file, args.hex))
+    if not dumps:
+        sys.exit('no trace dumps found')
+    for i, d in enumerate(dumps):
+        print('dump %d: %d of %d records, %d missed, at %.3f ms' %
+              (i, len(d['events']), d['size'], d['missed'], d['now'] / 1e3))
+    events = unwrap(dumps)
+    if not events:
+        return
+    if not args.quiet:
+        print_timeline(events)
+    # events between dumps are lost, so pair within each dump
+    lat = {}
+    for d in dumps:
+        for name, v in latencies(d['events']).items():
+            lat[name] = lat.get(name, []) + v
+    print_latencies(lat)
+
+main()
+
+#-----------------------------------------------------------------------------